@@ -0,0 +1,63 @@
+// Instantiates small_vector for many element types with several call sites
+// each, so that the size of the object file shows how much code every call
+// site and every element type costs, see the code_size target. Only the fast
+// path of push_back and emplace_back should be duplicated at the call sites
+// while growing is done out of line, and for trivially relocatable elements
+// by code shared between all element types, see small_vector_base.
+
+#include <cfds/small_vector.hpp>
+
+namespace {
+
+template <int I>
+struct payload {
+    int values[I % 4 + 1];
+};
+
+template <int I>
+using payload_vector = cfds::small_vector<payload<I>, 4>;
+
+template <int I, int Site>
+CFDS_NOINLINE void push_back_site(payload_vector<I>& v, int value) {
+    v.push_back(payload<I>{{value + Site}});
+}
+
+template <int I, int Site>
+CFDS_NOINLINE void emplace_back_site(payload_vector<I>& v) {
+    v.emplace_back();
+}
+
+template <int I>
+CFDS_NOINLINE void reshape_site(payload_vector<I>& v, payload_vector<I>& w) {
+    v.insert(v.begin(), 2, payload<I>{{I}});
+    v.erase(v.begin() + 1);
+    v.shrink_to_fit();
+    v.swap(w);
+}
+
+template <int I>
+struct call_sites {
+    static int run(int value) {
+        payload_vector<I> v;
+        payload_vector<I> w;
+        push_back_site<I, 0>(v, value);
+        push_back_site<I, 1>(v, value);
+        push_back_site<I, 2>(v, value);
+        push_back_site<I, 3>(v, value);
+        emplace_back_site<I, 0>(v);
+        emplace_back_site<I, 1>(v);
+        reshape_site<I>(v, w);
+
+        return static_cast<int>(v.size() + w.size()) +
+               call_sites<I - 1>::run(value);
+    }
+};
+
+template <>
+struct call_sites<0> {
+    static int run(int) { return 0; }
+};
+
+} // namespace
+
+int code_size_call_sites(int value) { return call_sites<32>::run(value); }
@@ -1,6 +1,25 @@
+#include <cfds/arena.hpp>
+#include <cfds/small_dense_set.hpp>
+#include <cfds/small_flat_map.hpp>
+#include <cfds/small_flat_set.hpp>
+#include <cfds/small_ring.hpp>
+#include <cfds/small_string.hpp>
 #include <cfds/small_vector.hpp>
+#include <cfds/static_vector.hpp>
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 static void BM_SmallVectorPushBackOne(benchmark::State& state) {
@@ -49,4 +68,903 @@ static void BM_StdVectorPushBackOverflow(benchmark::State& state) {
 }
 BENCHMARK(BM_StdVectorPushBackOverflow);
 
+// Growing a large heap buffer of trivially relocatable elements. std::allocator
+// has no reallocate so every doubling copies the buffer, malloc_allocator
+// goes through std::realloc and mapped_allocator through mremap.
+using copying_vector = cfds::small_vector<int, 0, std::allocator<int>>;
+using realloc_vector = cfds::small_vector<int, 0>;
+using mremap_vector = cfds::small_vector<int, 0, cfds::mapped_allocator<int>>;
+
+template <typename Vector>
+static void BM_PushBackLarge(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+
+    for (auto _ : state) {
+        Vector v;
+        benchmark::DoNotOptimize(v.data());
+        for (int i = 0; i < count; ++i) {
+            v.push_back(i);
+        }
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_PushBackLarge, copying_vector)->Range(1 << 12, 1 << 24);
+BENCHMARK_TEMPLATE(BM_PushBackLarge, realloc_vector)->Range(1 << 12, 1 << 24);
+BENCHMARK_TEMPLATE(BM_PushBackLarge, mremap_vector)->Range(1 << 12, 1 << 24);
+
+// Allocator keeping track of the number of (re)allocations and the peak number
+// of bytes held, used to compare the footprint of the growth policies.
+struct allocation_stats {
+    std::size_t allocations = 0;
+    std::size_t current_bytes = 0;
+    std::size_t peak_bytes = 0;
+
+    void add(std::size_t bytes) {
+        current_bytes += bytes;
+        peak_bytes = std::max(peak_bytes, current_bytes);
+    }
+
+    void remove(std::size_t bytes) { current_bytes -= bytes; }
+};
+
+static allocation_stats stats;
+
+template <typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    counting_allocator() = default;
+
+    template <typename U>
+    counting_allocator(const counting_allocator<U>&) {}
+
+    T* allocate(std::size_t count) {
+        ++stats.allocations;
+        stats.add(sizeof(T) * count);
+        return cfds::malloc_allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* ptr, std::size_t count) {
+        stats.remove(sizeof(T) * count);
+        cfds::malloc_allocator<T>().deallocate(ptr, count);
+    }
+
+    T* reallocate(T* ptr, std::size_t old_count, std::size_t new_count) {
+        ++stats.allocations;
+        stats.remove(sizeof(T) * old_count);
+        stats.add(sizeof(T) * new_count);
+        return cfds::malloc_allocator<T>().reallocate(ptr, old_count,
+                                                      new_count);
+    }
+
+    std::size_t usable_size(T* ptr, std::size_t count) const {
+        std::size_t usable =
+            cfds::malloc_allocator<T>().usable_size(ptr, count);
+        stats.add(sizeof(T) * (usable - count));
+        return usable;
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const counting_allocator<T>&, const counting_allocator<U>&) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const counting_allocator<T>&, const counting_allocator<U>&) {
+    return false;
+}
+
+using size_class_growth = cfds::size_class_growth<>;
+using factor_growth = cfds::factor_growth<>;
+using fixed_step_growth = cfds::fixed_step_growth<64>;
+
+template <typename Policy>
+static void BM_GrowthPolicyPushBack(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    stats = allocation_stats();
+
+    for (auto _ : state) {
+        cfds::small_vector<int, 4, counting_allocator<int>, Policy> v;
+        benchmark::DoNotOptimize(v.data());
+        for (int i = 0; i < count; ++i) {
+            v.push_back(i);
+        }
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["allocations"] =
+        benchmark::Counter(static_cast<double>(stats.allocations),
+                           benchmark::Counter::kAvgIterations);
+    state.counters["peak_bytes"] = static_cast<double>(stats.peak_bytes);
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_GrowthPolicyPushBack, cfds::power_of_two_growth)
+    ->Range(1 << 4, 1 << 16);
+BENCHMARK_TEMPLATE(BM_GrowthPolicyPushBack, factor_growth)
+    ->Range(1 << 4, 1 << 16);
+BENCHMARK_TEMPLATE(BM_GrowthPolicyPushBack, size_class_growth)
+    ->Range(1 << 4, 1 << 16);
+BENCHMARK_TEMPLATE(BM_GrowthPolicyPushBack, fixed_step_growth)
+    ->Range(1 << 4, 1 << 16);
+
+// Iterating an adjacency list where most vertices have at most two edges,
+// comparing the default three pointer header with compact_layout.
+using pointer_adjacency = cfds::small_vector<std::uint32_t, 2>;
+using compact_adjacency = cfds::compact_small_vector<std::uint32_t, 2>;
+
+template <typename Vector>
+static void BM_AdjacencyListIterate(benchmark::State& state) {
+    const int vertices = static_cast<int>(state.range(0));
+    std::vector<Vector> graph(vertices);
+
+    for (int i = 0; i < vertices; ++i) {
+        for (int j = 0; j < i % 4; ++j) {
+            graph[i].push_back(static_cast<std::uint32_t>(i + j));
+        }
+    }
+
+    for (auto _ : state) {
+        std::uint64_t sum = 0;
+        for (const auto& edges : graph) {
+            for (std::uint32_t edge : edges) {
+                sum += edge;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.counters["bytes_per_vertex"] = static_cast<double>(sizeof(Vector));
+    state.SetItemsProcessed(state.iterations() * vertices);
+}
+BENCHMARK_TEMPLATE(BM_AdjacencyListIterate, pointer_adjacency)
+    ->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_AdjacencyListIterate, compact_adjacency)
+    ->Range(1 << 10, 1 << 22);
+
+static void BM_ResizeThenFill(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+
+    for (auto _ : state) {
+        cfds::small_vector<char, 16> v;
+        v.resize(count);
+        std::memset(v.data(), 'a', v.size());
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ResizeThenFill)->Range(1 << 10, 1 << 20);
+
+static void BM_ResizeForOverwriteThenFill(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+
+    for (auto _ : state) {
+        cfds::small_vector<char, 16> v;
+        v.resize_for_overwrite(count);
+        std::memset(v.data(), 'a', v.size());
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ResizeForOverwriteThenFill)->Range(1 << 10, 1 << 20);
+
+static void BM_AppendUninitializedThenFill(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+
+    for (auto _ : state) {
+        cfds::small_vector<char, 16> v;
+        std::memset(v.append_uninitialized(count), 'a', count);
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_AppendUninitializedThenFill)->Range(1 << 10, 1 << 20);
+
+// Element by element assignment which the bulk range operations replace.
+static void BM_PushBackAssign(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    std::vector<int> source(count, 1);
+    cfds::small_vector<int, 16> v;
+
+    for (auto _ : state) {
+        v.clear();
+        v.reserve(count);
+        for (int value : source) {
+            v.push_back(value);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_PushBackAssign)->Range(1 << 4, 1 << 16);
+
+static void BM_RangeAssign(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    std::vector<int> source(count, 1);
+    cfds::small_vector<int, 16> v;
+
+    for (auto _ : state) {
+        v.assign(source.begin(), source.end());
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_RangeAssign)->Range(1 << 4, 1 << 16);
+
+static void BM_FillAssign(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    cfds::small_vector<int, 16> v;
+
+    for (auto _ : state) {
+        v.assign(count, 7);
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_FillAssign)->Range(1 << 4, 1 << 16);
+
+template <typename Vector>
+static void BM_RangeInsertFront(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    std::vector<int> source(count, 1);
+    Vector v;
+
+    for (auto _ : state) {
+        v.resize(16);
+        v.insert(v.begin(), source.begin(), source.end());
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_RangeInsertFront, cfds::small_vector<int, 16>)
+    ->Range(1 << 4, 1 << 16);
+BENCHMARK_TEMPLATE(BM_RangeInsertFront, std::vector<int>)
+    ->Range(1 << 4, 1 << 16);
+
+enum class insert_position { front, middle, back };
+
+// Builds a vector by inserting batches of four elements at the given position
+// until it holds state.range(0) elements.
+template <typename Vector, insert_position Position>
+static void BM_InsertBatches(benchmark::State& state) {
+    using value_type = typename Vector::value_type;
+    const int count = static_cast<int>(state.range(0));
+    const value_type batch[4] = {};
+
+    for (auto _ : state) {
+        Vector v;
+
+        for (int i = 0; i < count; i += 4) {
+            auto pos = v.end();
+            if (Position == insert_position::front) pos = v.begin();
+            if (Position == insert_position::middle) {
+                pos = v.begin() + v.size() / 2;
+            }
+
+            v.insert(pos, std::begin(batch), std::end(batch));
+        }
+
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_InsertBatches, cfds::small_vector<int, 16>,
+                   insert_position::front)
+    ->Range(1 << 6, 1 << 12);
+BENCHMARK_TEMPLATE(BM_InsertBatches, std::vector<int>, insert_position::front)
+    ->Range(1 << 6, 1 << 12);
+BENCHMARK_TEMPLATE(BM_InsertBatches, cfds::small_vector<int, 16>,
+                   insert_position::middle)
+    ->Range(1 << 6, 1 << 12);
+BENCHMARK_TEMPLATE(BM_InsertBatches, std::vector<int>,
+                   insert_position::middle)
+    ->Range(1 << 6, 1 << 12);
+BENCHMARK_TEMPLATE(BM_InsertBatches, cfds::small_vector<int, 16>,
+                   insert_position::back)
+    ->Range(1 << 6, 1 << 12);
+BENCHMARK_TEMPLATE(BM_InsertBatches, std::vector<int>, insert_position::back)
+    ->Range(1 << 6, 1 << 12);
+BENCHMARK_TEMPLATE(BM_InsertBatches, cfds::small_vector<std::string, 16>,
+                   insert_position::middle)
+    ->Range(1 << 6, 1 << 10);
+BENCHMARK_TEMPLATE(BM_InsertBatches, std::vector<std::string>,
+                   insert_position::middle)
+    ->Range(1 << 6, 1 << 10);
+
+// Models a request handler which builds a few hundred vectors that spill to
+// the heap and all die together when the request is done.
+static constexpr int request_vectors = 256;
+static constexpr int request_elements = 24;
+
+static void BM_RequestLifecycleMalloc(benchmark::State& state) {
+    for (auto _ : state) {
+        std::vector<cfds::small_vector<int, 8>> vectors(request_vectors);
+
+        for (auto& v : vectors) {
+            for (int i = 0; i < request_elements; ++i) {
+                v.push_back(i);
+            }
+        }
+
+        benchmark::DoNotOptimize(vectors.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * request_vectors);
+}
+BENCHMARK(BM_RequestLifecycleMalloc);
+
+static void BM_RequestLifecycleArena(benchmark::State& state) {
+    cfds::arena a;
+
+    for (auto _ : state) {
+        {
+            std::vector<cfds::arena_small_vector<int, 8>> vectors(
+                request_vectors, cfds::arena_small_vector<int, 8>(a));
+
+            for (auto& v : vectors) {
+                for (int i = 0; i < request_elements; ++i) {
+                    v.push_back(i);
+                }
+            }
+
+            benchmark::DoNotOptimize(vectors.data());
+        }
+
+        a.reset();
+    }
+
+    state.SetItemsProcessed(state.iterations() * request_vectors);
+}
+BENCHMARK(BM_RequestLifecycleArena);
+
+// Workers creating vectors which spill into blocks of the same size class and
+// destroying them right away.
+template <typename Vector>
+static void BM_SpillChurn(benchmark::State& state) {
+    for (auto _ : state) {
+        Vector v;
+        for (int i = 0; i < 12; ++i) {
+            v.push_back(i);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_SpillChurn, cfds::small_vector<int, 4>)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SpillChurn, cfds::cached_small_vector<int, 4>)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+// Posting lists stored as a vector of small vectors where every other list
+// has spilled. Growing the outer vector relocates the inner vectors, which
+// small_vector does through meta::relocate_traits.
+using posting_list = cfds::small_vector<std::uint32_t, 4>;
+
+template <typename Vector>
+static void BM_NestedGrowth(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+
+    for (auto _ : state) {
+        Vector lists;
+        for (int i = 0; i < count; ++i) {
+            posting_list list;
+            for (int j = 0; j < (i % 2 == 0 ? 2 : 6); ++j) {
+                list.push_back(static_cast<std::uint32_t>(j));
+            }
+            lists.push_back(std::move(list));
+        }
+        benchmark::DoNotOptimize(lists.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_NestedGrowth, cfds::small_vector<posting_list, 0>)
+    ->Range(1 << 8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_NestedGrowth, std::vector<posting_list>)
+    ->Range(1 << 8, 1 << 16);
+
+template <typename Vector>
+static void BM_NestedInsertFront(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+
+    for (auto _ : state) {
+        Vector lists;
+        for (int i = 0; i < count; ++i) {
+            lists.insert(lists.begin(), posting_list{1, 2});
+        }
+        benchmark::DoNotOptimize(lists.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_NestedInsertFront, cfds::small_vector<posting_list, 0>)
+    ->Range(1 << 6, 1 << 10);
+BENCHMARK_TEMPLATE(BM_NestedInsertFront, std::vector<posting_list>)
+    ->Range(1 << 6, 1 << 10);
+
+// Strings long enough to live on the heap, which take the memcpy path of
+// grow() and erase() wherever std::string is trivially relocatable, see
+// meta.hpp, and the move and destroy loop otherwise.
+template <typename Vector>
+static void BM_StringGrowth(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    const std::string value(32, 'x');
+
+    for (auto _ : state) {
+        Vector v;
+        for (int i = 0; i < count; ++i) {
+            v.push_back(value);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_StringGrowth, cfds::small_vector<std::string, 8>)
+    ->Range(1 << 4, 1 << 12);
+BENCHMARK_TEMPLATE(BM_StringGrowth, std::vector<std::string>)
+    ->Range(1 << 4, 1 << 12);
+
+template <typename Vector>
+static void BM_StringEraseFront(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    const std::vector<std::string> source(count, std::string(32, 'x'));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        Vector v(source.begin(), source.end());
+        state.ResumeTiming();
+
+        while (!v.empty()) {
+            v.erase(v.begin());
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_StringEraseFront, cfds::small_vector<std::string, 8>)
+    ->Range(1 << 4, 1 << 10);
+BENCHMARK_TEMPLATE(BM_StringEraseFront, std::vector<std::string>)
+    ->Range(1 << 4, 1 << 10);
+
+// Swapping vectors of handles where one of them has spilled, or both are
+// stored inline.
+using handle_vector = cfds::small_vector<std::unique_ptr<int>, 8>;
+
+static void fill_handles(handle_vector& v, int count) {
+    for (int i = 0; i < count; ++i) {
+        v.push_back(std::unique_ptr<int>(new int(i)));
+    }
+}
+
+static void BM_SwapInlineWithHeap(benchmark::State& state) {
+    handle_vector x;
+    handle_vector y;
+    fill_handles(x, 6);
+    fill_handles(y, 32);
+
+    for (auto _ : state) {
+        swap(x, y);
+        benchmark::DoNotOptimize(x.data());
+        benchmark::DoNotOptimize(y.data());
+    }
+}
+BENCHMARK(BM_SwapInlineWithHeap);
+
+static void BM_SwapInline(benchmark::State& state) {
+    handle_vector x;
+    handle_vector y;
+    fill_handles(x, 6);
+    fill_handles(y, 8);
+
+    for (auto _ : state) {
+        swap(x, y);
+        benchmark::DoNotOptimize(x.data());
+        benchmark::DoNotOptimize(y.data());
+    }
+}
+BENCHMARK(BM_SwapInline);
+
+// Filling a million ints, where push_back checks the capacity for every
+// element while the unchecked appender only checks it once.
+constexpr int fill_count = 1 << 20;
+
+static void BM_FillPushBack(benchmark::State& state) {
+    for (auto _ : state) {
+        cfds::small_vector<int, 16> v;
+        v.reserve(fill_count);
+        for (int i = 0; i < fill_count; ++i) {
+            v.push_back(i * 3);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * fill_count);
+}
+BENCHMARK(BM_FillPushBack);
+
+static void BM_FillStdVectorPushBack(benchmark::State& state) {
+    for (auto _ : state) {
+        std::vector<int> v;
+        v.reserve(fill_count);
+        for (int i = 0; i < fill_count; ++i) {
+            v.push_back(i * 3);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * fill_count);
+}
+BENCHMARK(BM_FillStdVectorPushBack);
+
+static void BM_FillUncheckedAppender(benchmark::State& state) {
+    for (auto _ : state) {
+        cfds::small_vector<int, 16> v;
+        {
+            auto out = v.back_inserter_unchecked(fill_count);
+            for (int i = 0; i < fill_count; ++i) {
+                out.push_back(i * 3);
+            }
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * fill_count);
+}
+BENCHMARK(BM_FillUncheckedAppender);
+
+static void BM_FillEmplaceBackN(benchmark::State& state) {
+    for (auto _ : state) {
+        cfds::small_vector<int, 16> v;
+        int i = 0;
+        v.emplace_back_n(fill_count, [&i] { return 3 * i++; });
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * fill_count);
+}
+BENCHMARK(BM_FillEmplaceBackN);
+
+// Appending to a vector with enough capacity, i.e. only the fast path of
+// push_back and emplace_back. The bench_perf target runs these with perf
+// counters, divide by 1024 to get the instructions per element.
+static void BM_PushBackFastPath(benchmark::State& state) {
+    cfds::small_vector<int, 16> v;
+    v.reserve(1024);
+
+    for (auto _ : state) {
+        v.clear();
+        for (int i = 0; i < 1024; ++i) {
+            v.push_back(i);
+        }
+        benchmark::DoNotOptimize(v.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_PushBackFastPath);
+
+static void BM_EmplaceBackFastPath(benchmark::State& state) {
+    cfds::small_vector<std::string, 16> v;
+    v.reserve(1024);
+
+    for (auto _ : state) {
+        v.clear();
+        for (int i = 0; i < 1024; ++i) {
+            v.emplace_back();
+        }
+        benchmark::DoNotOptimize(v.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_EmplaceBackFastPath);
+
+// Tiny maps like the ones held by the million, half of the lookups miss.
+static std::vector<int> shuffled_keys(int count) {
+    std::vector<int> keys;
+    for (int i = 0; i < count; ++i) {
+        keys.push_back(i * 7919);
+    }
+
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    return keys;
+}
+
+template <typename Map>
+static void BM_MapLookup(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    const std::vector<int> keys = shuffled_keys(count);
+
+    Map map;
+    for (int key : keys) {
+        map.emplace(key, key);
+    }
+
+    for (auto _ : state) {
+        int found = 0;
+        for (int key : keys) {
+            found += map.find(key) != map.end();
+            found += map.find(key + 1) != map.end();
+        }
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.SetItemsProcessed(state.iterations() * count * 2);
+}
+BENCHMARK_TEMPLATE(BM_MapLookup, cfds::small_flat_map<int, int, 8>)
+    ->RangeMultiplier(2)
+    ->Range(2, 256);
+BENCHMARK_TEMPLATE(BM_MapLookup, std::map<int, int>)
+    ->RangeMultiplier(2)
+    ->Range(2, 256);
+BENCHMARK_TEMPLATE(BM_MapLookup, std::unordered_map<int, int>)
+    ->RangeMultiplier(2)
+    ->Range(2, 256);
+
+template <typename Map>
+static void BM_MapBuild(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    const std::vector<int> keys = shuffled_keys(count);
+
+    for (auto _ : state) {
+        Map map;
+        for (int key : keys) {
+            map.emplace(key, key);
+        }
+        benchmark::DoNotOptimize(&map);
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_MapBuild, cfds::small_flat_map<int, int, 8>)
+    ->RangeMultiplier(2)
+    ->Range(2, 256);
+BENCHMARK_TEMPLATE(BM_MapBuild, std::map<int, int>)
+    ->RangeMultiplier(2)
+    ->Range(2, 256);
+BENCHMARK_TEMPLATE(BM_MapBuild, std::unordered_map<int, int>)
+    ->RangeMultiplier(2)
+    ->Range(2, 256);
+
+// Builds the map from a sorted batch with a single merge, see
+// small_flat_map::insert(sorted_unique, first, last).
+static void BM_FlatMapBuildSorted(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    std::vector<std::pair<int, int>> values;
+    for (int key : shuffled_keys(count)) {
+        values.emplace_back(key, key);
+    }
+    std::sort(values.begin(), values.end());
+
+    for (auto _ : state) {
+        cfds::small_flat_map<int, int, 8> map;
+        map.insert(cfds::sorted_unique, values.begin(), values.end());
+        benchmark::DoNotOptimize(&map);
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_FlatMapBuildSorted)->RangeMultiplier(2)->Range(2, 256);
+
+// Deduplicates a batch of ids where every id shows up twice, the way a
+// per-request seen set is used.
+template <typename Set>
+static void BM_DedupSet(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    const std::vector<int> keys = shuffled_keys(count);
+    std::vector<int> ids(keys);
+    ids.insert(ids.end(), keys.rbegin(), keys.rend());
+
+    for (auto _ : state) {
+        Set seen;
+        int unique = 0;
+        for (int id : ids) {
+            unique += seen.insert(id).second;
+        }
+        benchmark::DoNotOptimize(unique);
+    }
+
+    state.SetItemsProcessed(state.iterations() * 2 * count);
+}
+BENCHMARK_TEMPLATE(BM_DedupSet, cfds::small_dense_set<int, 16>)
+    ->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK_TEMPLATE(BM_DedupSet, cfds::small_flat_set<int, 16>)
+    ->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK_TEMPLATE(BM_DedupSet, std::unordered_set<int>)
+    ->RangeMultiplier(2)->Range(4, 256);
+
+template <typename Set>
+static void BM_SetLookup(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    std::vector<int> keys = shuffled_keys(count);
+    Set set(keys.begin(), keys.end());
+
+    for (auto _ : state) {
+        int found = 0;
+        for (int key : keys) {
+            found += static_cast<int>(set.count(key));
+            found += static_cast<int>(set.count(key + count));
+        }
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.SetItemsProcessed(state.iterations() * 2 * count);
+}
+BENCHMARK_TEMPLATE(BM_SetLookup, cfds::small_dense_set<int, 16>)
+    ->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK_TEMPLATE(BM_SetLookup, cfds::small_flat_set<int, 16>)
+    ->RangeMultiplier(2)->Range(4, 256);
+BENCHMARK_TEMPLATE(BM_SetLookup, std::unordered_set<int>)
+    ->RangeMultiplier(2)->Range(4, 256);
+
+// Strings of the lengths of typical tags and metric names, which don't fit
+// in the small string optimization of std::string past 15 characters.
+static std::string make_text(int length) {
+    std::string text;
+    for (int i = 0; i < length; ++i) {
+        text += static_cast<char>('a' + i % 26);
+    }
+
+    return text;
+}
+
+template <typename String>
+static void BM_StringConstruct(benchmark::State& state) {
+    const std::string text = make_text(static_cast<int>(state.range(0)));
+
+    for (auto _ : state) {
+        String str(text.data(), text.size());
+        benchmark::DoNotOptimize(str.data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_StringConstruct, cfds::small_string<64>)
+    ->Arg(8)->Arg(24)->Arg(48);
+BENCHMARK_TEMPLATE(BM_StringConstruct, std::string)->Arg(8)->Arg(24)->Arg(48);
+
+// Builds the string from 4 character pieces like a name joined from parts.
+template <typename String>
+static void BM_StringAppend(benchmark::State& state) {
+    const int length = static_cast<int>(state.range(0));
+    const std::string text = make_text(length);
+
+    for (auto _ : state) {
+        String str;
+        for (int i = 0; i < length; i += 4) {
+            str.append(text.data() + i, 4);
+        }
+        benchmark::DoNotOptimize(str.data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_StringAppend, cfds::small_string<64>)
+    ->Arg(8)->Arg(24)->Arg(48);
+BENCHMARK_TEMPLATE(BM_StringAppend, std::string)->Arg(8)->Arg(24)->Arg(48);
+
+// Compares strings which only differ in the last character.
+template <typename String>
+static void BM_StringCompare(benchmark::State& state) {
+    std::string text = make_text(static_cast<int>(state.range(0)));
+    const String x(text.data(), text.size());
+    text.back() = '!';
+    const String y(text.data(), text.size());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x == y);
+        benchmark::DoNotOptimize(x < y);
+    }
+
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK_TEMPLATE(BM_StringCompare, cfds::small_string<64>)
+    ->Arg(8)->Arg(24)->Arg(48);
+BENCHMARK_TEMPLATE(BM_StringCompare, std::string)->Arg(8)->Arg(24)->Arg(48);
+
+// Iterates many short vectors, e.g. the edges of a graph, where static_vector
+// reads the elements in place instead of through a pointer.
+template <typename Vector>
+static void BM_ShortVectorsIterate(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    std::vector<Vector> vectors(count);
+
+    for (int i = 0; i < count; ++i) {
+        for (int j = 0; j <= i % 4; ++j) {
+            vectors[i].push_back(static_cast<std::uint32_t>(i + j));
+        }
+    }
+
+    for (auto _ : state) {
+        std::uint64_t sum = 0;
+        for (const auto& vector : vectors) {
+            for (std::uint32_t value : vector) {
+                sum += value;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.counters["bytes_per_vector"] = static_cast<double>(sizeof(Vector));
+    state.SetItemsProcessed(state.iterations() * count);
+}
+using static_edges = cfds::static_vector<std::uint32_t, 4>;
+using small_edges = cfds::small_vector<std::uint32_t, 4>;
+
+BENCHMARK_TEMPLATE(BM_ShortVectorsIterate, static_edges)
+    ->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_ShortVectorsIterate, small_edges)
+    ->Range(1 << 10, 1 << 20);
+
+template <typename Vector>
+static void BM_ShortVectorFill(benchmark::State& state) {
+    for (auto _ : state) {
+        Vector vector;
+        for (std::uint32_t i = 0; i < 16; ++i) {
+            vector.push_back(i);
+        }
+        benchmark::DoNotOptimize(vector.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * 16);
+}
+BENCHMARK_TEMPLATE(BM_ShortVectorFill, cfds::static_vector<std::uint32_t, 16>);
+BENCHMARK_TEMPLATE(BM_ShortVectorFill, cfds::small_vector<std::uint32_t, 16>);
+
+// A breadth first style work queue which holds a handful of items at a time,
+// small_vector has to shift all items to take the first one.
+template <typename Queue>
+void pop_front(Queue& queue) {
+    queue.pop_front();
+}
+
+template <typename T, int N>
+void pop_front(cfds::small_vector<T, N>& queue) {
+    queue.erase(queue.begin());
+}
+
+template <typename Queue>
+static void BM_WorkQueue(benchmark::State& state) {
+    const int pending = static_cast<int>(state.range(0));
+
+    for (auto _ : state) {
+        Queue queue;
+        std::uint32_t sum = 0;
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            queue.push_back(i);
+            if (static_cast<int>(queue.size()) > pending) {
+                sum += queue.front();
+                pop_front(queue);
+            }
+        }
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * 256);
+}
+BENCHMARK_TEMPLATE(BM_WorkQueue, cfds::small_ring<std::uint32_t, 16>)
+    ->Arg(4)->Arg(12)->Arg(64);
+BENCHMARK_TEMPLATE(BM_WorkQueue, std::deque<std::uint32_t>)
+    ->Arg(4)->Arg(12)->Arg(64);
+BENCHMARK_TEMPLATE(BM_WorkQueue, cfds::small_vector<std::uint32_t, 16>)
+    ->Arg(4)->Arg(12)->Arg(64);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,383 @@
+// Contains the definition of malloc_allocator<T> which is the default
+// allocator used by the containers in cfds when they need to spill their
+// elements to the heap, as well as the helpers used to store an allocator
+// inside a container without paying for it when it's stateless.
+//
+// Allocators may provide reallocate(ptr, old_count, new_count) which the
+// containers use to resize heap buffers of trivially relocatable elements,
+// giving the allocator a chance to extend the block in place. They may also
+// provide usable_size(ptr, count) which reports how many elements actually fit
+// in a block, see size_class_growth<Policy>. Allocators aligning their blocks
+// beyond alignof(T) expose the alignment as a static alignment member, which
+// the containers also apply to their inline buffer.
+
+#pragma once
+
+#include "detail/utility.hpp"
+#include "meta.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define CFDS_MALLOC_USABLE_SIZE(ptr) ::malloc_usable_size(ptr)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define CFDS_MALLOC_USABLE_SIZE(ptr) ::malloc_size(ptr)
+#elif defined(_WIN32)
+#include <malloc.h>
+#define CFDS_MALLOC_USABLE_SIZE(ptr) ::_msize(ptr)
+#endif
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>) &&                                        \
+    ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
+#include <memory_resource>
+#define CFDS_HAS_PMR 1
+#endif
+#endif
+
+#ifndef CFDS_HAS_PMR
+#define CFDS_HAS_PMR 0
+#endif
+
+namespace cfds {
+
+// Stateless allocator built on std::malloc and std::free. It's the default
+// allocator of small_vector<T, N> since it grows buffers in place with
+// std::realloc, reports the real size of a block through usable_size() and
+// lets trivially relocatable elements share the non-template buffer code of
+// detail::small_vector_base.
+template <typename T>
+struct malloc_allocator {
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = malloc_allocator<U>;
+    };
+
+    malloc_allocator() noexcept = default;
+
+    template <typename U>
+    malloc_allocator(const malloc_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(
+            detail::safe_malloc(sizeof(T) * count, alignof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t) noexcept {
+        detail::aligned_free(ptr, alignof(T));
+    }
+
+    // The block is left untouched if std::realloc fails.
+    T* reallocate(T* ptr, std::size_t old_count, std::size_t new_count) {
+        return static_cast<T*>(
+            detail::safe_realloc(static_cast<void*>(ptr), sizeof(T) * old_count,
+                                 sizeof(T) * new_count, alignof(T)));
+    }
+
+    // Returns the number of elements that fits in the block which can be more
+    // than count since malloc rounds requests up to its size classes.
+    std::size_t usable_size(T* ptr, std::size_t count) const noexcept {
+#if defined(CFDS_MALLOC_USABLE_SIZE)
+        if (detail::is_over_aligned(alignof(T))) return count;
+        return std::max(count, CFDS_MALLOC_USABLE_SIZE(ptr) / sizeof(T));
+#else
+        static_cast<void>(ptr);
+        return count;
+#endif
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const malloc_allocator<T>&,
+                const malloc_allocator<U>&) noexcept {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const malloc_allocator<T>&,
+                const malloc_allocator<U>&) noexcept {
+    return false;
+}
+
+// Stateless allocator like malloc_allocator<T> whose blocks are aligned to
+// Alignment bytes, e.g. 64 to let SIMD code use aligned loads on the elements.
+// Containers in cfds align their inline buffer to the same boundary, see
+// aligned_small_vector<T, N, Alignment>.
+template <typename T, std::size_t Alignment>
+struct aligned_allocator {
+    static_assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0,
+                  "aligned_allocator<T, Alignment> requires Alignment to be a "
+                  "power of two.");
+
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    static constexpr std::size_t alignment =
+        Alignment > alignof(T) ? Alignment : alignof(T);
+
+    template <typename U>
+    struct rebind {
+        using other = aligned_allocator<U, Alignment>;
+    };
+
+    aligned_allocator() noexcept = default;
+
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(
+            detail::safe_malloc(sizeof(T) * count, alignment));
+    }
+
+    void deallocate(T* ptr, std::size_t) noexcept {
+        detail::aligned_free(ptr, alignment);
+    }
+
+    T* reallocate(T* ptr, std::size_t old_count, std::size_t new_count) {
+        return static_cast<T*>(
+            detail::safe_realloc(static_cast<void*>(ptr), sizeof(T) * old_count,
+                                 sizeof(T) * new_count, alignment));
+    }
+};
+
+template <typename T, std::size_t Alignment>
+constexpr std::size_t aligned_allocator<T, Alignment>::alignment;
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator==(const aligned_allocator<T, Alignment>&,
+                const aligned_allocator<U, Alignment>&) noexcept {
+    return true;
+}
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator!=(const aligned_allocator<T, Alignment>&,
+                const aligned_allocator<U, Alignment>&) noexcept {
+    return false;
+}
+
+#if defined(__linux__)
+
+// Allocator which places blocks of at least Threshold bytes in their own
+// anonymous memory mappings. Growing such a block is done with mremap which
+// moves the pages to a bigger mapping instead of copying their contents,
+// smaller blocks behave as if allocated by malloc_allocator<T>.
+template <typename T, std::size_t Threshold = (std::size_t(1) << 20)>
+struct mapped_allocator {
+    static_assert(Threshold > 0,
+                  "mapped_allocator<T, Threshold> requires Threshold to be "
+                  "greater than 0.");
+
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "mapped_allocator<T, Threshold> requires T to not be "
+                  "over-aligned.");
+
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = mapped_allocator<U, Threshold>;
+    };
+
+    mapped_allocator() noexcept = default;
+
+    template <typename U>
+    mapped_allocator(const mapped_allocator<U, Threshold>&) noexcept {}
+
+    T* allocate(std::size_t count) {
+        std::size_t bytes = sizeof(T) * count;
+        if (!is_mapped(bytes)) {
+            return static_cast<T*>(detail::safe_malloc(bytes));
+        }
+
+        void* data = ::mmap(nullptr, mapped_size(bytes), PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) throw std::bad_alloc();
+        return static_cast<T*>(data);
+    }
+
+    void deallocate(T* ptr, std::size_t count) noexcept {
+        std::size_t bytes = sizeof(T) * count;
+
+        if (is_mapped(bytes)) {
+            ::munmap(ptr, mapped_size(bytes));
+        } else {
+            std::free(ptr);
+        }
+    }
+
+    T* reallocate(T* ptr, std::size_t old_count, std::size_t new_count) {
+        std::size_t old_bytes = sizeof(T) * old_count;
+        std::size_t new_bytes = sizeof(T) * new_count;
+
+        if (!is_mapped(old_bytes) && !is_mapped(new_bytes)) {
+            void* data = std::realloc(static_cast<void*>(ptr), new_bytes);
+            if (data == nullptr) throw std::bad_alloc();
+            return static_cast<T*>(data);
+        }
+
+        if (is_mapped(old_bytes) && is_mapped(new_bytes)) {
+            void* data = ::mremap(ptr, mapped_size(old_bytes),
+                                  mapped_size(new_bytes), MREMAP_MAYMOVE);
+            if (data == MAP_FAILED) throw std::bad_alloc();
+            return static_cast<T*>(data);
+        }
+
+        // Crossing the threshold moves the block between malloc and a
+        // mapping which requires a copy.
+        T* new_ptr = allocate(new_count);
+        std::memcpy(static_cast<void*>(new_ptr), static_cast<void*>(ptr),
+                    std::min(old_bytes, new_bytes));
+        deallocate(ptr, old_count);
+        return new_ptr;
+    }
+
+ private:
+    static bool is_mapped(std::size_t bytes) noexcept {
+        return bytes >= Threshold;
+    }
+
+    static std::size_t mapped_size(std::size_t bytes) noexcept {
+        static const std::size_t page_size =
+            static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return (bytes + page_size - 1) / page_size * page_size;
+    }
+};
+
+#else
+
+// Memory mappings can only be resized in place on Linux so other platforms
+// fall back to std::realloc for every block size.
+template <typename T, std::size_t Threshold = (std::size_t(1) << 20)>
+struct mapped_allocator : malloc_allocator<T> {
+    template <typename U>
+    struct rebind {
+        using other = mapped_allocator<U, Threshold>;
+    };
+
+    mapped_allocator() noexcept = default;
+
+    template <typename U>
+    mapped_allocator(const mapped_allocator<U, Threshold>&) noexcept {}
+};
+
+#endif
+
+template <typename T, typename U, std::size_t Threshold>
+bool operator==(const mapped_allocator<T, Threshold>&,
+                const mapped_allocator<U, Threshold>&) noexcept {
+    return true;
+}
+
+template <typename T, typename U, std::size_t Threshold>
+bool operator!=(const mapped_allocator<T, Threshold>&,
+                const mapped_allocator<U, Threshold>&) noexcept {
+    return false;
+}
+
+namespace detail {
+
+template <typename Allocator>
+auto has_reallocate_impl(meta::priority_tag<1>)
+    -> decltype(std::declval<Allocator&>().reallocate(
+                    std::declval<typename Allocator::value_type*>(),
+                    std::size_t{}, std::size_t{}),
+                std::true_type{});
+
+template <typename Allocator>
+auto has_reallocate_impl(meta::priority_tag<0>) -> std::false_type;
+
+template <typename Allocator>
+struct has_reallocate
+    : decltype(has_reallocate_impl<Allocator>(meta::priority_tag<1>{})) {};
+
+template <typename Allocator>
+auto allocator_alignment_impl(meta::priority_tag<1>)
+    -> std::integral_constant<std::size_t, Allocator::alignment>;
+
+template <typename Allocator>
+auto allocator_alignment_impl(meta::priority_tag<0>)
+    -> std::integral_constant<std::size_t,
+                              alignof(typename Allocator::value_type)>;
+
+// The alignment of the blocks returned by Allocator, which is given by a
+// static alignment member when the allocator over-aligns its blocks.
+template <typename Allocator>
+struct allocator_alignment
+    : decltype(allocator_alignment_impl<Allocator>(meta::priority_tag<1>{})) {
+};
+
+template <typename Allocator>
+auto has_usable_size_impl(meta::priority_tag<1>)
+    -> decltype(std::declval<const Allocator&>().usable_size(
+                    std::declval<typename Allocator::value_type*>(),
+                    std::size_t{}),
+                std::true_type{});
+
+template <typename Allocator>
+auto has_usable_size_impl(meta::priority_tag<0>) -> std::false_type;
+
+template <typename Allocator>
+struct has_usable_size
+    : decltype(has_usable_size_impl<Allocator>(meta::priority_tag<1>{})) {};
+
+// Allocators whose blocks come straight from safe_malloc() and go back through
+// aligned_free(), which lets containers manage the blocks of trivially
+// relocatable elements through small_vector_base instead.
+template <typename Allocator>
+struct is_malloc_based_allocator : std::false_type {};
+
+template <typename T>
+struct is_malloc_based_allocator<malloc_allocator<T>> : std::true_type {};
+
+template <typename T, std::size_t Alignment>
+struct is_malloc_based_allocator<aligned_allocator<T, Alignment>>
+    : std::true_type {};
+
+// Stores an allocator as a base class when it's empty so that stateless
+// allocators doesn't increase the size of the container.
+template <typename Allocator, bool = std::is_empty<Allocator>::value>
+class allocator_holder : private Allocator {
+ public:
+    allocator_holder() = default;
+    explicit allocator_holder(const Allocator& alloc) : Allocator(alloc) {}
+
+    Allocator& allocator_ref() noexcept { return *this; }
+    const Allocator& allocator_ref() const noexcept { return *this; }
+};
+
+template <typename Allocator>
+class allocator_holder<Allocator, false> {
+ public:
+    allocator_holder() = default;
+    explicit allocator_holder(const Allocator& alloc) : m_allocator(alloc) {}
+
+    Allocator& allocator_ref() noexcept { return m_allocator; }
+    const Allocator& allocator_ref() const noexcept { return m_allocator; }
+
+ private:
+    Allocator m_allocator;
+};
+
+} // namespace detail
+} // namespace cfds
@@ -0,0 +1,231 @@
+// Contains the definition of arena, a monotonic allocator which hands out
+// memory by bumping a pointer through chunks obtained from malloc and releases
+// everything at once, together with arena_allocator<T> which lets containers
+// in cfds spill their elements into an arena.
+//
+// Deallocating through an arena_allocator<T> is a noop which makes destroying
+// a container of trivially destructible elements free, the memory is returned
+// to the arena with reset() or release() when all containers using it are
+// gone. An arena isn't thread safe, it's meant to be owned by a single thread,
+// e.g. one per request handler or a thread_local instance.
+//
+// The allocator is part of the header type, so arena_small_vector<T, N> binds
+// to arena_small_vector_header<T>& but not to small_vector_header<T>&. This
+// can't be avoided by making arena_allocator stateless, since the default
+// header frees and grows its heap buffer with free and realloc through
+// malloc_allocator<T>, which must never be handed memory from an arena.
+// Functions taking vectors of either kind have to be templates on the
+// allocator or take the elements as a pointer and a size.
+
+#pragma once
+
+#include "detail/utility.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace cfds {
+
+class arena {
+ public:
+    // The first chunk is allocated lazily and every following chunk is twice
+    // the size of the previous one.
+    explicit arena(std::size_t initial_chunk_size = 4096) noexcept
+        : m_next_chunk_size(std::max<std::size_t>(initial_chunk_size, 64)) {}
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    ~arena() { release(); }
+
+    // Returns bytes of memory aligned to alignment which has to be a power of
+    // two. The memory is valid until reset() or release() is called.
+    void* allocate(std::size_t bytes,
+                   std::size_t alignment = alignof(std::max_align_t)) {
+        char* ptr = align_up(m_ptr, alignment);
+
+        if (ptr != nullptr && ptr <= m_end &&
+            bytes <= static_cast<std::size_t>(m_end - ptr)) {
+            m_ptr = ptr + bytes;
+            return ptr;
+        }
+
+        return allocate_slow(bytes, alignment);
+    }
+
+    // Resizes the block at ptr in place, which is only possible for the most
+    // recent allocation when the current chunk has room for new_bytes.
+    bool try_resize(void* ptr, std::size_t old_bytes,
+                    std::size_t new_bytes) noexcept {
+        char* begin = static_cast<char*>(ptr);
+        if (begin + old_bytes != m_ptr) return false;
+        if (new_bytes > static_cast<std::size_t>(m_end - begin)) return false;
+
+        m_ptr = begin + new_bytes;
+        return true;
+    }
+
+    // Makes all memory available again while keeping the largest chunk, so
+    // that an arena reused for similar work stops calling malloc once it has
+    // warmed up. An oversized request can make an older chunk the largest.
+    void reset() noexcept {
+        if (m_head == nullptr) return;
+
+        chunk* largest = m_head;
+        for (chunk* c = m_head->next; c != nullptr; c = c->next) {
+            if (c->size > largest->size) largest = c;
+        }
+
+        chunk* c = m_head;
+        while (c != nullptr) {
+            chunk* next = c->next;
+            if (c != largest) std::free(c);
+            c = next;
+        }
+
+        m_head = largest;
+        m_head->next = nullptr;
+        m_ptr = chunk_data(m_head);
+        m_end = m_ptr + m_head->size;
+    }
+
+    // Returns all memory to malloc.
+    void release() noexcept {
+        free_chunks(m_head);
+        m_head = nullptr;
+        m_ptr = nullptr;
+        m_end = nullptr;
+    }
+
+ private:
+    struct chunk {
+        chunk* next;
+        std::size_t size;
+    };
+
+    chunk* m_head = nullptr;
+    char* m_ptr = nullptr;
+    char* m_end = nullptr;
+    std::size_t m_next_chunk_size;
+
+    static std::size_t header_size() noexcept {
+        const std::size_t align = alignof(std::max_align_t);
+        return (sizeof(chunk) + align - 1) / align * align;
+    }
+
+    static char* chunk_data(chunk* c) noexcept {
+        return reinterpret_cast<char*>(c) + header_size();
+    }
+
+    static char* align_up(char* ptr, std::size_t alignment) noexcept {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(ptr);
+        std::uintptr_t aligned = (address + alignment - 1) & ~(alignment - 1);
+        return ptr + (aligned - address);
+    }
+
+    static void free_chunks(chunk* c) noexcept {
+        while (c != nullptr) {
+            chunk* next = c->next;
+            std::free(c);
+            c = next;
+        }
+    }
+
+    void* allocate_slow(std::size_t bytes, std::size_t alignment) {
+        std::size_t padding = alignment > alignof(std::max_align_t)
+                                  ? alignment
+                                  : std::size_t(0);
+        std::size_t max = std::numeric_limits<std::size_t>::max();
+        if (bytes > max - header_size() - padding) throw std::bad_alloc();
+
+        std::size_t size = std::max(m_next_chunk_size, bytes + padding);
+        void* data = detail::safe_malloc(header_size() + size);
+
+        chunk* c = static_cast<chunk*>(data);
+        c->next = m_head;
+        c->size = size;
+
+        m_head = c;
+        m_ptr = chunk_data(c);
+        m_end = m_ptr + size;
+
+        if (m_next_chunk_size <= max / 2) m_next_chunk_size *= 2;
+
+        return allocate(bytes, alignment);
+    }
+};
+
+// Allocator which bump allocates from an arena and never frees anything. It
+// propagates on move assignment and swap so that containers can exchange
+// buffers belonging to different arenas.
+template <typename T>
+struct arena_allocator {
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = arena_allocator<U>;
+    };
+
+    arena_allocator(arena& a) noexcept : m_arena(&a) {}
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept
+        : m_arena(other.m_arena) {}
+
+    T* allocate(std::size_t count) {
+        if (count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+
+        return static_cast<T*>(
+            m_arena->allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) noexcept {}
+
+    // Extends the block in place when it's the last allocation of the arena,
+    // otherwise the elements are copied to a new block and the old one is
+    // simply abandoned.
+    T* reallocate(T* ptr, std::size_t old_count, std::size_t new_count) {
+        if (m_arena->try_resize(ptr, sizeof(T) * old_count,
+                                sizeof(T) * new_count)) {
+            return ptr;
+        }
+
+        T* new_ptr = allocate(new_count);
+        std::memcpy(static_cast<void*>(new_ptr), static_cast<void*>(ptr),
+                    sizeof(T) * std::min(old_count, new_count));
+        return new_ptr;
+    }
+
+    arena* resource() const noexcept { return m_arena; }
+
+ private:
+    template <typename U>
+    friend struct arena_allocator;
+
+    arena* m_arena;
+};
+
+template <typename T, typename U>
+bool operator==(const arena_allocator<T>& x,
+                const arena_allocator<U>& y) noexcept {
+    return x.resource() == y.resource();
+}
+
+template <typename T, typename U>
+bool operator!=(const arena_allocator<T>& x,
+                const arena_allocator<U>& y) noexcept {
+    return !(x == y);
+}
+
+} // namespace cfds
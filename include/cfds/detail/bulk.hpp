@@ -0,0 +1,251 @@
+// Contains the bulk operations used by the containers in cfds to copy, fill,
+// relocate and shift ranges of elements. When T is trivially copyable and the
+// source is contiguous memory holding T, copies collapse into a single
+// std::memcpy and fills into std::memset or a handful of doubling std::memcpy
+// calls instead of constructing the elements one at a time. Likewise trivially
+// relocatable elements are relocated and shifted with std::memcpy and
+// std::memmove.
+
+#pragma once
+
+#include "../meta.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cfds {
+namespace detail {
+
+// Iterators which are known to point into contiguous memory, i.e. pointers and
+// the iterators of std::vector<T>.
+template <typename Iterator, typename T>
+struct is_contiguous_iterator
+    : meta::bool_constant<
+          std::is_pointer<Iterator>::value ||
+          (!std::is_same<T, bool>::value &&
+           (std::is_same<Iterator, typename std::vector<T>::iterator>::value ||
+            std::is_same<Iterator,
+                         typename std::vector<T>::const_iterator>::value))> {
+};
+
+// Whether elements of type T can be copied from Iterator with std::memcpy.
+template <typename Iterator, typename T>
+struct is_memcpyable_iterator
+    : meta::bool_constant<
+          std::is_trivially_copyable<T>::value &&
+          is_contiguous_iterator<Iterator, T>::value &&
+          std::is_same<typename std::remove_cv<typename std::iterator_traits<
+                           Iterator>::value_type>::type,
+                       T>::value> {};
+
+template <typename Iterator>
+const void* to_address(Iterator iter) {
+    return static_cast<const void*>(std::addressof(*iter));
+}
+
+// Copy constructs count elements from first into the uninitialized memory at
+// dest and returns the end of the constructed range. Nothing is left
+// constructed if a constructor throws.
+template <typename T, typename Iterator>
+typename std::enable_if<is_memcpyable_iterator<Iterator, T>::value, T*>::type
+uninitialized_copy_n(Iterator first, std::size_t count, T* dest) {
+    if (count > 0) {
+        std::memcpy(static_cast<void*>(dest), to_address(first),
+                    sizeof(T) * count);
+    }
+
+    return dest + count;
+}
+
+template <typename T, typename Iterator>
+typename std::enable_if<!is_memcpyable_iterator<Iterator, T>::value, T*>::type
+uninitialized_copy_n(Iterator first, std::size_t count, T* dest) {
+    return std::uninitialized_copy_n(first, count, dest);
+}
+
+// Copy assigns count elements from first to the live elements at dest.
+template <typename T, typename Iterator>
+typename std::enable_if<is_memcpyable_iterator<Iterator, T>::value, T*>::type
+copy_n(Iterator first, std::size_t count, T* dest) {
+    if (count > 0) {
+        std::memmove(static_cast<void*>(dest), to_address(first),
+                     sizeof(T) * count);
+    }
+
+    return dest + count;
+}
+
+template <typename T, typename Iterator>
+typename std::enable_if<!is_memcpyable_iterator<Iterator, T>::value, T*>::type
+copy_n(Iterator first, std::size_t count, T* dest) {
+    return std::copy_n(first, count, dest);
+}
+
+// Single byte types are filled with std::memset.
+template <typename T>
+typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                        sizeof(T) == 1>::type
+uninitialized_fill_n(T* dest, std::size_t count, const T& value) {
+    unsigned char byte;
+    std::memcpy(&byte, std::addressof(value), 1);
+    std::memset(static_cast<void*>(dest), byte, count);
+}
+
+// Wider types write a short prefix element by element and then double the
+// filled prefix with std::memcpy, which lets the library use its widest stores
+// for the broadcast regardless of whether the compiler vectorizes a loop.
+template <typename T>
+typename std::enable_if<std::is_trivially_copyable<T>::value &&
+                        (sizeof(T) > 1)>::type
+uninitialized_fill_n(T* dest, std::size_t count, const T& value) {
+    const T copy = value;
+    std::size_t prefix = std::min<std::size_t>(count, 32);
+
+    for (std::size_t i = 0; i < prefix; ++i) {
+        ::new (static_cast<void*>(dest + i)) T(copy);
+    }
+
+    for (std::size_t filled = prefix; filled < count;) {
+        std::size_t chunk = std::min(filled, count - filled);
+        std::memcpy(static_cast<void*>(dest + filled),
+                    static_cast<const void*>(dest), sizeof(T) * chunk);
+        filled += chunk;
+    }
+}
+
+template <typename T>
+typename std::enable_if<!std::is_trivially_copyable<T>::value>::type
+uninitialized_fill_n(T* dest, std::size_t count, const T& value) {
+    std::uninitialized_fill_n(dest, count, value);
+}
+
+// Turn destroy_range into a noop when T is trivially destructible.
+template <typename T>
+typename std::enable_if<std::is_trivially_destructible<T>::value>::type
+destroy_range(const T*, const T*) noexcept {}
+
+template <typename T>
+typename std::enable_if<!std::is_trivially_destructible<T>::value>::type
+destroy_range(const T* first, const T* last) noexcept {
+    for (; first != last; ++first) {
+        first->~T();
+    }
+}
+
+template <typename InputIterator, typename ForwardIterator>
+void uninitialized_move(InputIterator first, InputIterator last,
+                        ForwardIterator dest) {
+    std::uninitialized_copy(std::make_move_iterator(first),
+                            std::make_move_iterator(last), dest);
+}
+
+// Relocate using std::memcpy if T is trivially relocatable.
+template <typename T>
+typename std::enable_if<meta::is_trivially_relocatable<T>::value>::type
+uninitialized_relocate(const T* first, const T* last, T* dest) noexcept {
+    std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first),
+                sizeof(T) * static_cast<std::size_t>(last - first));
+}
+
+// Relocate the elements one by one since there is no risk of throwing, see
+// meta::relocate_at.
+template <typename T>
+typename std::enable_if<!meta::is_trivially_relocatable<T>::value &&
+                        meta::is_nothrow_relocatable<T>::value>::type
+uninitialized_relocate(const T* first, const T* last, T* dest) noexcept {
+    for (; first != last; ++first, (void)++dest) {
+        meta::relocate_at(const_cast<T*>(first), dest);
+    }
+}
+
+// Relocate by calling the constructor and only after all elements have been
+// relocated can the destructor for the old shells be called since the
+// constructor might throw.
+template <typename T>
+typename std::enable_if<!meta::is_nothrow_relocatable<T>::value>::type
+uninitialized_relocate(const T* first, const T* last, T* dest) {
+    for (const T* iter = first; iter != last; ++iter, (void)++dest) {
+        ::new (static_cast<void*>(dest)) T(std::move(*const_cast<T*>(iter)));
+    }
+
+    destroy_range(first, last);
+}
+
+// Shift using std::memmove if T is trivially relocatable.
+template <typename T>
+typename std::enable_if<meta::is_trivially_relocatable<T>::value>::type
+shift_data(const T* first, const T* last, T* dest) noexcept {
+    std::memmove(static_cast<void*>(dest), static_cast<const void*>(first),
+                 sizeof(T) * static_cast<std::size_t>(last - first));
+}
+
+// Shift by relocating the elements one by one, see meta::relocate_at.
+template <typename T>
+typename std::enable_if<!meta::is_trivially_relocatable<T>::value>::type
+shift_data(const T* first, const T* last, T* dest) {
+    if (dest < first) {
+        for (; first != last; ++first, (void)++dest) {
+            meta::relocate_at(const_cast<T*>(first), dest);
+        }
+    } else {
+        // Walk backwards so that no element is overwritten before it has
+        // been moved when the ranges overlap.
+        dest += last - first;
+
+        while (last != first) {
+            --last;
+            --dest;
+            meta::relocate_at(const_cast<T*>(last), dest);
+        }
+    }
+}
+
+// Shifts the elements in [pos, last) count steps towards the end, leaving
+// count uninitialized elements at pos, given room for count elements after
+// last. Used when relocating is cheap.
+template <typename T>
+void open_gap(T* pos, T* last, std::size_t count, std::true_type) noexcept {
+    shift_data(pos, last, pos + count);
+}
+
+// Move constructs the elements which end up past last and move assigns the
+// rest, like std::vector, which is cheaper than constructing and destroying
+// every element in the tail. Nothing past last is left constructed if a move
+// throws.
+template <typename T>
+void open_gap(T* pos, T* last, std::size_t count, std::false_type) {
+    std::size_t tail = static_cast<std::size_t>(last - pos);
+
+    if (count >= tail) {
+        uninitialized_relocate(pos, last, pos + count);
+        return;
+    }
+
+    // Qualified since std::uninitialized_move would be found through ADL.
+    detail::uninitialized_move(last - count, last, last);
+
+    try {
+        std::move_backward(pos, last - count, last);
+    } catch (...) {
+        destroy_range(last, last + count);
+        throw;
+    }
+
+    destroy_range(pos, pos + count);
+}
+
+template <typename T>
+void open_gap(T* pos, T* last, std::size_t count) {
+    open_gap(pos, last, count,
+             meta::bool_constant<meta::is_trivially_relocatable<T>::value ||
+                                 meta::relocate_traits<T>::value>{});
+}
+
+} // namespace detail
+} // namespace cfds
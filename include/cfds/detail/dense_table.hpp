@@ -0,0 +1,806 @@
+// Contains dense_table which implements small_dense_map and small_dense_set as
+// an open addressing hash table in the style of SwissTable. Every slot has a
+// control byte which is either empty, deleted or holds 7 bits of the hash of
+// the element in the slot. The control bytes are split into groups of 16
+// which are matched against the hash with a few SSE2 instructions when
+// available, so that a lookup usually compares a single key.
+//
+// Groups are aligned and probed quadratically from the group selected by the
+// hash, a lookup stops at the first group containing an empty slot. Tables of
+// at most N slots live inline in the container and larger tables are kept in
+// a single heap block holding both the control bytes and the slots. Elements
+// are relocated with std::memcpy when the table is rehashed if they're
+// trivially relocatable, the hash function must not throw.
+
+#pragma once
+
+#include "../meta.hpp"
+#include "bulk.hpp"
+#include "utility.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CFDS_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace cfds {
+namespace detail {
+
+using dense_ctrl = std::int8_t;
+
+// Full slots have a non-negative control byte, the sentinel marks the end of
+// the table for iterators and pads tables smaller than a group.
+constexpr dense_ctrl dense_empty = -128;
+constexpr dense_ctrl dense_deleted = -2;
+constexpr dense_ctrl dense_sentinel = -1;
+
+constexpr std::size_t dense_group_size = 16;
+
+// The control bytes of a table with capacity slots, rounded up to whole
+// groups with room for at least one sentinel.
+constexpr std::size_t dense_ctrl_bytes(std::size_t capacity) {
+    return (capacity + dense_group_size) / dense_group_size *
+           dense_group_size;
+}
+
+// Tables are kept at most 7/8 full so that lookups of missing keys stop
+// early, small tables only need a single empty slot.
+constexpr std::size_t dense_max_load(std::size_t capacity) {
+    return capacity < 8 ? capacity - 1 : capacity - capacity / 8;
+}
+
+// Spreads the bits of the hash since std::hash is often the identity, the
+// low 7 bits become the control byte and the rest selects the group.
+inline std::uint64_t dense_mix(std::uint64_t hash) noexcept {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+inline int count_trailing_zeros(std::uint32_t bits) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(bits);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<int>(index);
+#else
+    int count = 0;
+    for (; (bits & 1) == 0; bits >>= 1) ++count;
+    return count;
+#endif
+}
+
+// The control bytes of a group, the match functions return a mask with bit i
+// set when the control byte of slot i matches.
+class dense_group {
+ public:
+#if defined(CFDS_HAS_SSE2)
+    explicit dense_group(const dense_ctrl* ctrl) noexcept
+        : m_ctrl(_mm_load_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+    std::uint32_t match(dense_ctrl hash) const noexcept {
+        return mask(_mm_cmpeq_epi8(_mm_set1_epi8(hash), m_ctrl));
+    }
+
+    std::uint32_t match_empty() const noexcept {
+        return mask(_mm_cmpeq_epi8(_mm_set1_epi8(dense_empty), m_ctrl));
+    }
+
+    // Empty and deleted slots are the ones below the sentinel.
+    std::uint32_t match_free() const noexcept {
+        return mask(_mm_cmpgt_epi8(_mm_set1_epi8(dense_sentinel), m_ctrl));
+    }
+
+ private:
+    __m128i m_ctrl;
+
+    static std::uint32_t mask(__m128i bytes) noexcept {
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(bytes));
+    }
+#else
+    explicit dense_group(const dense_ctrl* ctrl) noexcept {
+        std::memcpy(m_ctrl, ctrl, dense_group_size);
+    }
+
+    std::uint32_t match(dense_ctrl hash) const noexcept {
+        std::uint32_t bits = 0;
+        for (std::size_t i = 0; i < dense_group_size; ++i) {
+            bits |= static_cast<std::uint32_t>(m_ctrl[i] == hash) << i;
+        }
+        return bits;
+    }
+
+    std::uint32_t match_empty() const noexcept { return match(dense_empty); }
+
+    std::uint32_t match_free() const noexcept {
+        std::uint32_t bits = 0;
+        for (std::size_t i = 0; i < dense_group_size; ++i) {
+            bits |= static_cast<std::uint32_t>(m_ctrl[i] < dense_sentinel)
+                    << i;
+        }
+        return bits;
+    }
+
+ private:
+    dense_ctrl m_ctrl[dense_group_size];
+#endif
+};
+
+template <typename T>
+class dense_iterator {
+ public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename std::remove_const<T>::type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    dense_iterator() = default;
+
+    template <typename U,
+              typename = typename std::enable_if<
+                  !std::is_same<U, T>::value &&
+                  std::is_same<const U, T>::value>::type>
+    dense_iterator(const dense_iterator<U>& other) noexcept
+        : m_ctrl(other.m_ctrl), m_slot(other.m_slot) {}
+
+    // Points at the first full slot starting from slot.
+    dense_iterator(const dense_ctrl* ctrl, T* slot) noexcept
+        : m_ctrl(ctrl), m_slot(slot) {
+        skip_free();
+    }
+
+    reference operator*() const noexcept { return *m_slot; }
+    pointer operator->() const noexcept { return m_slot; }
+
+    dense_iterator& operator++() noexcept {
+        ++m_ctrl;
+        ++m_slot;
+        skip_free();
+        return *this;
+    }
+
+    dense_iterator operator++(int) noexcept {
+        dense_iterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    friend bool operator==(const dense_iterator& x,
+                           const dense_iterator& y) noexcept {
+        return x.m_slot == y.m_slot;
+    }
+
+    friend bool operator!=(const dense_iterator& x,
+                           const dense_iterator& y) noexcept {
+        return x.m_slot != y.m_slot;
+    }
+
+ private:
+    template <typename>
+    friend class dense_iterator;
+
+    template <typename, typename, typename, typename, typename, int>
+    friend class dense_table;
+
+    const dense_ctrl* m_ctrl = nullptr;
+    T* m_slot = nullptr;
+
+    // The sentinel after the last slot stops the loop.
+    void skip_free() noexcept {
+        while (*m_ctrl < dense_sentinel) {
+            ++m_ctrl;
+            ++m_slot;
+        }
+    }
+};
+
+// Stores the hash function and the key equality as base classes when they're
+// empty so that they don't increase the size of the container.
+template <typename Hash, bool = std::is_empty<Hash>::value>
+class hasher_holder : private Hash {
+ public:
+    hasher_holder() = default;
+    explicit hasher_holder(const Hash& hash) : Hash(hash) {}
+
+    const Hash& hasher_ref() const noexcept { return *this; }
+};
+
+template <typename Hash>
+class hasher_holder<Hash, false> {
+ public:
+    hasher_holder() = default;
+    explicit hasher_holder(const Hash& hash) : m_hash(hash) {}
+
+    const Hash& hasher_ref() const noexcept { return m_hash; }
+
+ private:
+    Hash m_hash;
+};
+
+template <typename KeyEqual, bool = std::is_empty<KeyEqual>::value>
+class key_equal_holder : private KeyEqual {
+ public:
+    key_equal_holder() = default;
+    explicit key_equal_holder(const KeyEqual& equal) : KeyEqual(equal) {}
+
+    const KeyEqual& key_equal_ref() const noexcept { return *this; }
+};
+
+template <typename KeyEqual>
+class key_equal_holder<KeyEqual, false> {
+ public:
+    key_equal_holder() = default;
+    explicit key_equal_holder(const KeyEqual& equal) : m_equal(equal) {}
+
+    const KeyEqual& key_equal_ref() const noexcept { return m_equal; }
+
+ private:
+    KeyEqual m_equal;
+};
+
+template <typename Key, typename Value, typename KeyOfValue, typename Hash,
+          typename KeyEqual, int N>
+class dense_table : private hasher_holder<Hash>,
+                    private key_equal_holder<KeyEqual> {
+    static_assert(N > 0 && (N & (N - 1)) == 0,
+                  "dense_table<..., N> requires N to be a power of two.");
+
+    static_assert(meta::is_nothrow_relocatable<Value>::value,
+                  "dense_table<Key, Value, ...> requires Value to be nothrow "
+                  "relocatable.");
+
+    using pointer = Value*;
+
+ public:
+    using key_type = Key;
+    using value_type = Value;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    // The elements of a set are keys so they can't be modified in place.
+    using iterator = dense_iterator<
+        typename std::conditional<std::is_same<Key, Value>::value,
+                                  const value_type, value_type>::type>;
+    using const_iterator = dense_iterator<const value_type>;
+
+    dense_table() noexcept { reset(); }
+
+    explicit dense_table(const Hash& hash, const KeyEqual& equal = KeyEqual())
+        : hasher_holder<Hash>(hash), key_equal_holder<KeyEqual>(equal) {
+        reset();
+    }
+
+    template <typename InputIterator,
+              typename = typename std::enable_if<
+                  meta::is_input_iterator<InputIterator>::value>::type>
+    dense_table(InputIterator first, InputIterator last,
+                const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+        : dense_table(hash, equal) {
+        insert(first, last);
+    }
+
+    dense_table(std::initializer_list<value_type> ilist,
+                const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual())
+        : dense_table(ilist.begin(), ilist.end(), hash, equal) {}
+
+    dense_table(const dense_table& other)
+        : dense_table(other.hasher_ref(), other.key_equal_ref()) {
+        copy_elements(other);
+    }
+
+    // Never allocates since a heap table is stolen and an inline table fits
+    // in the inline slots.
+    dense_table(dense_table&& other) noexcept
+        : dense_table(other.hasher_ref(), other.key_equal_ref()) {
+        take_elements(other);
+    }
+
+    ~dense_table() {
+        destroy_elements();
+        if (!is_small()) deallocate();
+    }
+
+    dense_table& operator=(const dense_table& other) {
+        if (this != &other) {
+            dense_table copy(other);
+            *this = std::move(copy);
+        }
+
+        return *this;
+    }
+
+    dense_table& operator=(dense_table&& other) noexcept {
+        if (this != &other) {
+            release();
+            hasher_holder<Hash>::operator=(other);
+            key_equal_holder<KeyEqual>::operator=(other);
+            take_elements(other);
+        }
+
+        return *this;
+    }
+
+    dense_table& operator=(std::initializer_list<value_type> ilist) {
+        clear();
+        insert(ilist);
+        return *this;
+    }
+
+    iterator begin() noexcept { return iterator(m_ctrl, m_slots); }
+    const_iterator begin() const noexcept {
+        return const_iterator(m_ctrl, m_slots);
+    }
+    const_iterator cbegin() const noexcept { return begin(); }
+
+    iterator end() noexcept { return iterator_at(m_capacity); }
+    const_iterator end() const noexcept { return iterator_at(m_capacity); }
+    const_iterator cend() const noexcept { return end(); }
+
+    bool empty() const noexcept { return m_size == 0; }
+    size_type size() const noexcept { return m_size; }
+    size_type capacity() const noexcept { return m_capacity; }
+    bool is_small() const noexcept { return m_ctrl == m_inline_ctrl; }
+
+    size_type max_size() const noexcept {
+        return std::numeric_limits<difference_type>::max() /
+               (sizeof(value_type) + 1) / 2;
+    }
+
+    hasher hash_function() const { return this->hasher_ref(); }
+    key_equal key_eq() const { return this->key_equal_ref(); }
+
+    // Keeps the table but makes all slots empty.
+    void clear() noexcept {
+        destroy_elements();
+        reset_ctrl(m_ctrl, m_capacity);
+        m_size = 0;
+        m_growth_left = dense_max_load(m_capacity);
+    }
+
+    // Makes room for count elements without rehashing.
+    void reserve(size_type count) {
+        if (count <= m_size + m_growth_left) return;
+
+        size_type capacity = m_capacity;
+        while (dense_max_load(capacity) < count) {
+            if (capacity > max_size() / 2) throw_length_error();
+            capacity *= 2;
+        }
+
+        rehash(capacity);
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        value_type value(std::forward<Args>(args)...);
+        return emplace_unique(KeyOfValue{}(value), std::move(value));
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) {
+        return emplace_unique(KeyOfValue{}(value), value);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value) {
+        return emplace_unique(KeyOfValue{}(value), std::move(value));
+    }
+
+    template <typename InputIterator>
+    typename std::enable_if<
+        meta::is_input_iterator<InputIterator>::value>::type
+    insert(InputIterator first, InputIterator last) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> ilist) {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    // Erasing never moves other elements so the returned iterator points at
+    // the element following pos.
+    iterator erase(const_iterator pos) noexcept {
+        size_type index = static_cast<size_type>(pos.m_slot - m_slots);
+        iterator next = iterator_at(index + 1);
+        erase_at(index);
+
+        return next;
+    }
+
+    size_type erase(const key_type& key) {
+        size_type index = find_index(key);
+        if (index == npos) return 0;
+
+        erase_at(index);
+        return 1;
+    }
+
+    void swap(dense_table& other) noexcept {
+        dense_table tmp(std::move(other));
+        other.take_elements(*this);
+        take_elements(tmp);
+
+        using std::swap;
+        swap(static_cast<hasher_holder<Hash>&>(*this),
+             static_cast<hasher_holder<Hash>&>(other));
+        swap(static_cast<key_equal_holder<KeyEqual>&>(*this),
+             static_cast<key_equal_holder<KeyEqual>&>(other));
+    }
+
+    iterator find(const key_type& key) {
+        size_type index = find_index(key);
+        return index == npos ? end() : iterator_at(index);
+    }
+
+    const_iterator find(const key_type& key) const {
+        size_type index = find_index(key);
+        return index == npos ? end() : iterator_at(index);
+    }
+
+    size_type count(const key_type& key) const {
+        return find_index(key) != npos ? 1 : 0;
+    }
+
+    bool contains(const key_type& key) const {
+        return find_index(key) != npos;
+    }
+
+    friend bool operator==(const dense_table& x, const dense_table& y) {
+        if (x.size() != y.size()) return false;
+
+        for (const value_type& value : x) {
+            const_iterator pos = y.find(KeyOfValue{}(value));
+            if (pos == y.end() || !(*pos == value)) return false;
+        }
+
+        return true;
+    }
+
+    friend bool operator!=(const dense_table& x, const dense_table& y) {
+        return !(x == y);
+    }
+
+ protected:
+    // Constructs the value from args unless an element with an equal key
+    // already exists. The key is only used before the value is constructed
+    // so it may refer to one of the args.
+    template <typename... Args>
+    std::pair<iterator, bool> emplace_unique(const key_type& key,
+                                             Args&&... args) {
+        std::uint64_t hash = hash_of(key);
+        size_type index = find_index(key, hash);
+        if (index != npos) return {iterator_at(index), false};
+
+        index = find_free(m_ctrl, m_capacity, hash);
+
+        // Deleted slots can be reused without using up an empty slot.
+        if (CFDS_UNLIKELY(m_growth_left == 0 &&
+                          m_ctrl[index] == dense_empty)) {
+            grow();
+            index = find_free(m_ctrl, m_capacity, hash);
+        }
+
+        ::new (static_cast<void*>(m_slots + index))
+            value_type(std::forward<Args>(args)...);
+
+        if (m_ctrl[index] == dense_empty) --m_growth_left;
+        m_ctrl[index] = short_hash(hash);
+        ++m_size;
+
+        return {iterator_at(index), true};
+    }
+
+ private:
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    static constexpr std::size_t block_alignment =
+        alignof(value_type) > dense_group_size ? alignof(value_type)
+                                               : dense_group_size;
+
+    dense_ctrl* m_ctrl;
+    pointer m_slots;
+    size_type m_capacity;
+    size_type m_size;
+    size_type m_growth_left;
+
+    alignas(dense_group_size) dense_ctrl m_inline_ctrl[dense_ctrl_bytes(N)];
+    aligned_storage_base<value_type, N> m_inline_slots;
+
+    iterator iterator_at(size_type index) noexcept {
+        return iterator(m_ctrl + index, m_slots + index);
+    }
+
+    const_iterator iterator_at(size_type index) const noexcept {
+        return const_iterator(m_ctrl + index, m_slots + index);
+    }
+
+    std::uint64_t hash_of(const key_type& key) const {
+        return dense_mix(static_cast<std::uint64_t>(this->hasher_ref()(key)));
+    }
+
+    static dense_ctrl short_hash(std::uint64_t hash) noexcept {
+        return static_cast<dense_ctrl>(hash & 0x7f);
+    }
+
+    static size_type group_count(size_type capacity) noexcept {
+        return (capacity + dense_group_size - 1) / dense_group_size;
+    }
+
+    size_type find_index(const key_type& key) const {
+        return find_index(key, hash_of(key));
+    }
+
+    // Probing visits every group since the number of groups is a power of
+    // two and the step grows by one group every time.
+    size_type find_index(const key_type& key, std::uint64_t hash) const {
+        size_type mask = group_count(m_capacity) - 1;
+        size_type group = static_cast<size_type>(hash >> 7) & mask;
+        dense_ctrl h2 = short_hash(hash);
+
+        for (size_type step = 1;; ++step) {
+            const dense_ctrl* ctrl = m_ctrl + group * dense_group_size;
+            dense_group slots(ctrl);
+
+            for (std::uint32_t bits = slots.match(h2); bits != 0;
+                 bits &= bits - 1) {
+                size_type index = group * dense_group_size +
+                                  count_trailing_zeros(bits);
+
+                if (CFDS_LIKELY(this->key_equal_ref()(
+                        KeyOfValue{}(m_slots[index]), key))) {
+                    return index;
+                }
+            }
+
+            if (slots.match_empty() != 0) return npos;
+            group = (group + step) & mask;
+        }
+    }
+
+    // Returns the first empty or deleted slot on the probe sequence of hash.
+    static size_type find_free(const dense_ctrl* ctrl, size_type capacity,
+                               std::uint64_t hash) noexcept {
+        size_type mask = group_count(capacity) - 1;
+        size_type group = static_cast<size_type>(hash >> 7) & mask;
+
+        for (size_type step = 1;; ++step) {
+            std::uint32_t bits =
+                dense_group(ctrl + group * dense_group_size).match_free();
+
+            if (bits != 0) {
+                return group * dense_group_size + count_trailing_zeros(bits);
+            }
+
+            group = (group + step) & mask;
+        }
+    }
+
+    // A slot can be marked as empty instead of deleted when its group has
+    // an empty slot, since no probe sequence passed the group when it had an
+    // empty slot all along.
+    void erase_at(size_type index) noexcept {
+        m_slots[index].~value_type();
+        --m_size;
+
+        const dense_ctrl* group =
+            m_ctrl + index / dense_group_size * dense_group_size;
+
+        if (dense_group(group).match_empty() != 0) {
+            m_ctrl[index] = dense_empty;
+            ++m_growth_left;
+        } else {
+            m_ctrl[index] = dense_deleted;
+        }
+    }
+
+    // Doubles the capacity unless most of the used up slots are deleted, in
+    // which case rehashing at the same capacity gets rid of them.
+    CFDS_NOINLINE void grow() {
+        if (m_size >= dense_max_load(m_capacity) / 2) {
+            if (m_capacity > max_size() / 2) throw_length_error();
+            rehash(m_capacity * 2);
+        } else {
+            rehash(m_capacity);
+        }
+    }
+
+    void rehash(size_type capacity) {
+        if (capacity == m_capacity) {
+            rehash_in_place();
+            return;
+        }
+
+        std::size_t ctrl_bytes = dense_ctrl_bytes(capacity);
+        std::size_t slot_offset = (ctrl_bytes + alignof(value_type) - 1) /
+                                  alignof(value_type) * alignof(value_type);
+
+        char* block = static_cast<char*>(safe_malloc(
+            slot_offset + sizeof(value_type) * capacity, block_alignment));
+        dense_ctrl* ctrl = reinterpret_cast<dense_ctrl*>(block);
+        pointer slots = reinterpret_cast<pointer>(block + slot_offset);
+
+        reset_ctrl(ctrl, capacity);
+
+        for (size_type i = 0; i < m_capacity; ++i) {
+            if (m_ctrl[i] < 0) continue;
+
+            std::uint64_t hash = hash_of(KeyOfValue{}(m_slots[i]));
+            size_type index = find_free(ctrl, capacity, hash);
+
+            detail::uninitialized_relocate(m_slots + i, m_slots + i + 1,
+                                           slots + index);
+            ctrl[index] = short_hash(hash);
+        }
+
+        if (!is_small()) deallocate();
+
+        m_ctrl = ctrl;
+        m_slots = slots;
+        m_capacity = capacity;
+        m_growth_left = dense_max_load(capacity) - m_size;
+    }
+
+    // Gets rid of the deleted slots without allocating, so an inline table
+    // stays inline. Full slots are marked as deleted and deleted slots as
+    // empty, then every element marked as deleted is moved to the first
+    // free slot of its probe sequence. An element is left in place when
+    // that slot is in its own group, and is swapped with the element in the
+    // slot when that one hasn't been placed yet.
+    void rehash_in_place() noexcept {
+        for (size_type i = 0; i < m_capacity; ++i) {
+            m_ctrl[i] = m_ctrl[i] >= 0 ? dense_deleted : dense_empty;
+        }
+
+        aligned_storage_base<value_type, 1> scratch;
+        pointer tmp = reinterpret_cast<pointer>(scratch.buffer);
+
+        for (size_type i = 0; i < m_capacity; ++i) {
+            if (m_ctrl[i] != dense_deleted) continue;
+
+            std::uint64_t hash = hash_of(KeyOfValue{}(m_slots[i]));
+            size_type index = find_free(m_ctrl, m_capacity, hash);
+
+            if (index / dense_group_size == i / dense_group_size) {
+                m_ctrl[i] = short_hash(hash);
+                continue;
+            }
+
+            if (m_ctrl[index] == dense_empty) {
+                detail::uninitialized_relocate(m_slots + i, m_slots + i + 1,
+                                               m_slots + index);
+                m_ctrl[i] = dense_empty;
+                m_ctrl[index] = short_hash(hash);
+                continue;
+            }
+
+            pointer other = m_slots + index;
+            detail::uninitialized_relocate(other, other + 1, tmp);
+            detail::uninitialized_relocate(m_slots + i, m_slots + i + 1,
+                                           other);
+            detail::uninitialized_relocate(tmp, tmp + 1, m_slots + i);
+            m_ctrl[index] = short_hash(hash);
+            --i;
+        }
+
+        m_growth_left = dense_max_load(m_capacity) - m_size;
+    }
+
+    static void reset_ctrl(dense_ctrl* ctrl, size_type capacity) noexcept {
+        std::memset(ctrl, static_cast<unsigned char>(dense_empty), capacity);
+        std::memset(ctrl + capacity, static_cast<unsigned char>(dense_sentinel),
+                    dense_ctrl_bytes(capacity) - capacity);
+    }
+
+    // Switches to the empty inline table without releasing anything.
+    void reset() noexcept {
+        m_ctrl = m_inline_ctrl;
+        m_slots = reinterpret_cast<pointer>(m_inline_slots.buffer);
+        m_capacity = static_cast<size_type>(N);
+        m_size = 0;
+        m_growth_left = dense_max_load(m_capacity);
+        reset_ctrl(m_ctrl, m_capacity);
+    }
+
+    void release() noexcept {
+        destroy_elements();
+        if (!is_small()) deallocate();
+        reset();
+    }
+
+    void deallocate() noexcept { aligned_free(m_ctrl, block_alignment); }
+
+    void destroy_elements() noexcept {
+        destroy_elements(std::is_trivially_destructible<value_type>{});
+    }
+
+    void destroy_elements(std::true_type) noexcept {}
+
+    void destroy_elements(std::false_type) noexcept {
+        for (size_type i = 0; i < m_capacity; ++i) {
+            if (m_ctrl[i] >= 0) m_slots[i].~value_type();
+        }
+    }
+
+    void copy_elements(const dense_table& other) {
+        reserve(other.size());
+
+        for (const value_type& value : other) {
+            std::uint64_t hash = hash_of(KeyOfValue{}(value));
+            size_type index = find_free(m_ctrl, m_capacity, hash);
+
+            ::new (static_cast<void*>(m_slots + index)) value_type(value);
+            m_ctrl[index] = short_hash(hash);
+            --m_growth_left;
+            ++m_size;
+        }
+    }
+
+    // Takes the elements of other, which is left empty, given that this
+    // table is empty and inline. Both inline tables have N slots so the
+    // elements keep their position when relocated between them.
+    void take_elements(dense_table& other) noexcept {
+        if (!other.is_small()) {
+            m_ctrl = other.m_ctrl;
+            m_slots = other.m_slots;
+            m_capacity = other.m_capacity;
+            m_size = other.m_size;
+            m_growth_left = other.m_growth_left;
+            other.reset();
+            return;
+        }
+
+        std::memcpy(m_inline_ctrl, other.m_inline_ctrl, sizeof(m_inline_ctrl));
+
+        for (size_type i = 0; i < m_capacity; ++i) {
+            if (m_ctrl[i] < 0) continue;
+            pointer slot = other.m_slots + i;
+            detail::uninitialized_relocate(slot, slot + 1, m_slots + i);
+        }
+
+        m_size = other.m_size;
+        m_growth_left = other.m_growth_left;
+        other.reset();
+    }
+
+    [[noreturn]] CFDS_COLD static void throw_length_error() {
+        throw std::length_error("cfds::dense_table exceeded max_size()");
+    }
+};
+
+template <typename Key, typename Value, typename KeyOfValue, typename Hash,
+          typename KeyEqual, int N>
+constexpr typename dense_table<Key, Value, KeyOfValue, Hash, KeyEqual,
+                               N>::size_type
+    dense_table<Key, Value, KeyOfValue, Hash, KeyEqual, N>::npos;
+
+template <typename Key, typename Value, typename KeyOfValue, typename Hash,
+          typename KeyEqual, int N>
+constexpr std::size_t
+    dense_table<Key, Value, KeyOfValue, Hash, KeyEqual, N>::block_alignment;
+
+} // namespace detail
+} // namespace cfds
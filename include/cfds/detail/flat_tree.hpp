@@ -0,0 +1,490 @@
+// Contains flat_tree which implements small_flat_map and small_flat_set as a
+// small_vector of values sorted by key. Lookups scan the elements linearly
+// while there are at most flat_linear_search_limit<T>() of them, which beats
+// a binary search on the handful of elements these containers usually hold,
+// and switch to a branchless binary search above that.
+
+#pragma once
+
+#include "../meta.hpp"
+#include "../small_vector.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace cfds {
+
+// Tag telling the flat containers that a range is sorted by key and holds no
+// duplicate keys, which lets them skip sorting it.
+struct sorted_unique_t {
+    explicit sorted_unique_t() = default;
+};
+
+constexpr sorted_unique_t sorted_unique{};
+
+namespace detail {
+
+// Halves the range without branching on the comparison, which lets the
+// compiler use a conditional move. The range always holds the result.
+template <typename T, typename Predicate>
+T* flat_binary_search(T* first, std::ptrdiff_t count, Predicate before) {
+    while (count > 1) {
+        std::ptrdiff_t half = count / 2;
+        first = before(first[half]) ? first + half : first;
+        count -= half;
+    }
+
+    return first + (before(*first) ? 1 : 0);
+}
+
+// The number of elements which are searched linearly, fewer for large
+// elements since comparing them is usually more expensive.
+template <typename T>
+constexpr std::ptrdiff_t flat_linear_search_limit() {
+    return sizeof(T) <= 16 ? 8 : 4;
+}
+
+// Returns the first element in [first, last) for which before returns false,
+// given that before is true for a prefix of the range.
+template <typename T, typename Predicate>
+T* flat_partition_point(T* first, T* last, Predicate before) {
+    if (last - first > flat_linear_search_limit<T>()) {
+        return flat_binary_search(first, last - first, before);
+    }
+
+    while (first != last && before(*first)) ++first;
+    return first;
+}
+
+// Stores the comparison as a base class when it's empty so that std::less<Key>
+// doesn't increase the size of the container.
+template <typename Compare, bool = std::is_empty<Compare>::value>
+class compare_holder : private Compare {
+ public:
+    compare_holder() = default;
+    explicit compare_holder(const Compare& comp) : Compare(comp) {}
+
+    const Compare& compare_ref() const noexcept { return *this; }
+};
+
+template <typename Compare>
+class compare_holder<Compare, false> {
+ public:
+    compare_holder() = default;
+    explicit compare_holder(const Compare& comp) : m_compare(comp) {}
+
+    const Compare& compare_ref() const noexcept { return m_compare; }
+
+ private:
+    Compare m_compare;
+};
+
+template <typename Key, typename Value, typename KeyOfValue, typename Compare,
+          int N>
+class flat_tree : private compare_holder<Compare> {
+    using storage_type = small_vector<Value, N>;
+    using pointer = Value*;
+
+ public:
+    using key_type = Key;
+    using value_type = Value;
+    using key_compare = Compare;
+    using size_type = typename storage_type::size_type;
+    using difference_type = std::ptrdiff_t;
+
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    // The elements of a set are keys so they can't be modified in place.
+    using iterator =
+        typename std::conditional<std::is_same<Key, Value>::value,
+                                  const value_type*, value_type*>::type;
+    using const_iterator = const value_type*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    flat_tree() = default;
+
+    explicit flat_tree(const Compare& comp) : compare_holder<Compare>(comp) {}
+
+    template <typename InputIterator,
+              typename = typename std::enable_if<
+                  meta::is_input_iterator<InputIterator>::value>::type>
+    flat_tree(InputIterator first, InputIterator last,
+              const Compare& comp = Compare())
+        : compare_holder<Compare>(comp), m_data(first, last) {
+        sort_unique(m_data);
+    }
+
+    flat_tree(std::initializer_list<value_type> ilist,
+              const Compare& comp = Compare())
+        : flat_tree(ilist.begin(), ilist.end(), comp) {}
+
+    template <typename InputIterator,
+              typename = typename std::enable_if<
+                  meta::is_input_iterator<InputIterator>::value>::type>
+    flat_tree(sorted_unique_t, InputIterator first, InputIterator last,
+              const Compare& comp = Compare())
+        : compare_holder<Compare>(comp), m_data(first, last) {}
+
+    flat_tree(sorted_unique_t, std::initializer_list<value_type> ilist,
+              const Compare& comp = Compare())
+        : flat_tree(sorted_unique, ilist.begin(), ilist.end(), comp) {}
+
+    flat_tree& operator=(std::initializer_list<value_type> ilist) {
+        storage_type data(ilist.begin(), ilist.end());
+        sort_unique(data);
+        m_data.swap(data);
+        return *this;
+    }
+
+    iterator begin() noexcept { return m_data.begin(); }
+    const_iterator begin() const noexcept { return m_data.begin(); }
+    const_iterator cbegin() const noexcept { return m_data.begin(); }
+
+    iterator end() noexcept { return m_data.end(); }
+    const_iterator end() const noexcept { return m_data.end(); }
+    const_iterator cend() const noexcept { return m_data.end(); }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator crbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+    bool empty() const noexcept { return m_data.empty(); }
+    size_type size() const noexcept { return m_data.size(); }
+    size_type max_size() const noexcept { return m_data.max_size(); }
+    size_type capacity() const noexcept { return m_data.capacity(); }
+    bool is_small() const { return m_data.is_small(); }
+
+    void reserve(size_type count) { m_data.reserve(count); }
+    void shrink_to_fit() { m_data.shrink_to_fit(); }
+    void clear() noexcept { m_data.clear(); }
+
+    key_compare key_comp() const { return this->compare_ref(); }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        value_type value(std::forward<Args>(args)...);
+        return emplace_unique(KeyOfValue{}(value), std::move(value));
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) {
+        return emplace_unique(KeyOfValue{}(value), value);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value) {
+        return emplace_unique(KeyOfValue{}(value), std::move(value));
+    }
+
+    // The value is inserted right before hint when that keeps the elements
+    // sorted, otherwise hint is ignored.
+    iterator insert(const_iterator hint, const value_type& value) {
+        return emplace_hint_unique(hint, KeyOfValue{}(value), value);
+    }
+
+    iterator insert(const_iterator hint, value_type&& value) {
+        return emplace_hint_unique(hint, KeyOfValue{}(value),
+                                   std::move(value));
+    }
+
+    // The values are sorted on their own before being merged into the
+    // elements in a single pass. The first of several values with equal keys
+    // is inserted, like inserting them one by one would.
+    template <typename InputIterator>
+    typename std::enable_if<
+        meta::is_input_iterator<InputIterator>::value>::type
+    insert(InputIterator first, InputIterator last) {
+        storage_type values(first, last);
+        sort_unique(values);
+        merge_unique(std::make_move_iterator(values.begin()),
+                     std::make_move_iterator(values.end()), values.size());
+    }
+
+    void insert(std::initializer_list<value_type> ilist) {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    // Merges the values into the elements in a single pass without sorting
+    // them first. Values are simply appended when they all belong after the
+    // last element, which makes building a container from sorted data linear.
+    template <typename InputIterator>
+    typename std::enable_if<
+        meta::is_input_iterator<InputIterator>::value &&
+        !meta::is_forward_iterator<InputIterator>::value>::type
+    insert(sorted_unique_t, InputIterator first, InputIterator last) {
+        storage_type values(first, last);
+        insert(sorted_unique, std::make_move_iterator(values.begin()),
+               std::make_move_iterator(values.end()));
+    }
+
+    template <typename ForwardIterator>
+    typename std::enable_if<
+        meta::is_forward_iterator<ForwardIterator>::value>::type
+    insert(sorted_unique_t, ForwardIterator first, ForwardIterator last) {
+        if (first == last) return;
+
+        if (empty() || less(KeyOfValue{}(m_data.back()),
+                            KeyOfValue{}(*first))) {
+            m_data.insert(m_data.end(), first, last);
+            return;
+        }
+
+        merge_unique(first, last,
+                     static_cast<size_type>(std::distance(first, last)));
+    }
+
+    void insert(sorted_unique_t, std::initializer_list<value_type> ilist) {
+        insert(sorted_unique, ilist.begin(), ilist.end());
+    }
+
+    iterator erase(const_iterator pos) { return m_data.erase(pos); }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        return m_data.erase(first, last);
+    }
+
+    size_type erase(const key_type& key) {
+        const_iterator pos = find(key);
+        if (pos == end()) return 0;
+
+        m_data.erase(pos);
+        return 1;
+    }
+
+    void swap(flat_tree& other) {
+        using std::swap;
+        swap(static_cast<compare_holder<Compare>&>(*this),
+             static_cast<compare_holder<Compare>&>(other));
+        m_data.swap(other.m_data);
+    }
+
+    iterator find(const key_type& key) { return to_mutable(find_pos(key)); }
+    const_iterator find(const key_type& key) const { return find_pos(key); }
+
+    size_type count(const key_type& key) const {
+        return find_pos(key) != end() ? 1 : 0;
+    }
+
+    bool contains(const key_type& key) const {
+        return find_pos(key) != end();
+    }
+
+    iterator lower_bound(const key_type& key) {
+        return to_mutable(lower_bound_pos(key));
+    }
+    const_iterator lower_bound(const key_type& key) const {
+        return lower_bound_pos(key);
+    }
+
+    iterator upper_bound(const key_type& key) {
+        return to_mutable(upper_bound_pos(key));
+    }
+    const_iterator upper_bound(const key_type& key) const {
+        return upper_bound_pos(key);
+    }
+
+    std::pair<iterator, iterator> equal_range(const key_type& key) {
+        pointer first = to_mutable(lower_bound_pos(key));
+        pointer last = first;
+        if (last != m_data.end() && !less(key, KeyOfValue{}(*last))) ++last;
+
+        return {first, last};
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(
+        const key_type& key) const {
+        const_iterator first = lower_bound_pos(key);
+        const_iterator last = first;
+        if (last != end() && !less(key, KeyOfValue{}(*last))) ++last;
+
+        return {first, last};
+    }
+
+    friend bool operator==(const flat_tree& x, const flat_tree& y) {
+        return x.m_data == y.m_data;
+    }
+
+    friend bool operator!=(const flat_tree& x, const flat_tree& y) {
+        return !(x == y);
+    }
+
+    friend bool operator<(const flat_tree& x, const flat_tree& y) {
+        return x.m_data < y.m_data;
+    }
+
+    friend bool operator>(const flat_tree& x, const flat_tree& y) {
+        return y < x;
+    }
+
+    friend bool operator<=(const flat_tree& x, const flat_tree& y) {
+        return !(y < x);
+    }
+
+    friend bool operator>=(const flat_tree& x, const flat_tree& y) {
+        return !(x < y);
+    }
+
+ protected:
+    bool less(const key_type& x, const key_type& y) const {
+        return this->compare_ref()(x, y);
+    }
+
+    // Constructs the value from args at its sorted position unless an
+    // element with an equal key already exists. The key is only used before
+    // the value is constructed so it may refer to one of the args.
+    template <typename... Args>
+    std::pair<iterator, bool> emplace_unique(const key_type& key,
+                                             Args&&... args) {
+        pointer pos = m_data.end();
+
+        if (!empty() && !less(KeyOfValue{}(m_data.back()), key)) {
+            pos = to_mutable(lower_bound_pos(key));
+            if (!less(key, KeyOfValue{}(*pos))) return {pos, false};
+        }
+
+        return {m_data.emplace(pos, std::forward<Args>(args)...), true};
+    }
+
+    template <typename... Args>
+    iterator emplace_hint_unique(const_iterator hint, const key_type& key,
+                                 Args&&... args) {
+        if ((hint == begin() || less(KeyOfValue{}(hint[-1]), key)) &&
+            (hint == end() || less(key, KeyOfValue{}(*hint)))) {
+            return m_data.emplace(hint, std::forward<Args>(args)...);
+        }
+
+        return emplace_unique(key, std::forward<Args>(args)...).first;
+    }
+
+ private:
+    storage_type m_data;
+
+    pointer to_mutable(const_iterator pos) noexcept {
+        return m_data.begin() + (pos - m_data.cbegin());
+    }
+
+    const_iterator lower_bound_pos(const key_type& key) const {
+        return flat_partition_point(
+            m_data.begin(), m_data.end(), [this, &key](const value_type& x) {
+                return less(KeyOfValue{}(x), key);
+            });
+    }
+
+    const_iterator upper_bound_pos(const key_type& key) const {
+        return flat_partition_point(
+            m_data.begin(), m_data.end(), [this, &key](const value_type& x) {
+                return !less(key, KeyOfValue{}(x));
+            });
+    }
+
+    const_iterator find_pos(const key_type& key) const {
+        const_iterator pos = lower_bound_pos(key);
+        if (pos != end() && less(key, KeyOfValue{}(*pos))) return end();
+
+        return pos;
+    }
+
+    // Sorts the values by key keeping the first of several values with equal
+    // keys. Small ranges are insertion sorted since std::stable_sort
+    // allocates a scratch buffer.
+    void sort_unique(storage_type& values) const {
+        auto before = [this](const value_type& x, const value_type& y) {
+            return less(KeyOfValue{}(x), KeyOfValue{}(y));
+        };
+
+        auto not_before = [&before](const value_type& x,
+                                    const value_type& y) {
+            return !before(x, y);
+        };
+
+        pointer first = values.begin();
+        pointer last = values.end();
+
+        if (std::adjacent_find(first, last, not_before) == last) return;
+
+        if (last - first <= 16) {
+            insertion_sort(first, last, before);
+        } else {
+            std::stable_sort(first, last, before);
+        }
+
+        values.erase(std::unique(first, last, not_before), last);
+    }
+
+    template <typename Before>
+    static void insertion_sort(pointer first, pointer last, Before before) {
+        for (pointer i = first + 1; i < last; ++i) {
+            if (!before(*i, i[-1])) continue;
+
+            value_type value = std::move(*i);
+            pointer pos = i;
+
+            for (; pos != first && before(value, pos[-1]); --pos) {
+                *pos = std::move(pos[-1]);
+            }
+
+            *pos = std::move(value);
+        }
+    }
+
+    // Merges count values which are sorted and unique into the elements,
+    // values whose key is already present are skipped. If constructing a
+    // value throws the values merged so far are kept.
+    template <typename Iterator>
+    void merge_unique(Iterator first, Iterator last, size_type count) {
+        storage_type merged;
+        pointer pos = m_data.begin();
+        pointer end = m_data.end();
+        std::exception_ptr error;
+
+        {
+            // Reserves room for all elements so that the remaining ones can
+            // still be appended after a value has thrown.
+            auto out = merged.back_inserter_unchecked(size() + count);
+
+            try {
+                for (; first != last; ++first) {
+                    auto&& value = *first;
+                    const key_type& key = KeyOfValue{}(value);
+
+                    for (; pos != end && less(KeyOfValue{}(*pos), key);
+                         ++pos) {
+                        out.emplace_back(std::move(*pos));
+                    }
+
+                    if (pos == end || less(key, KeyOfValue{}(*pos))) {
+                        out.emplace_back(std::forward<decltype(value)>(value));
+                    }
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            for (; pos != end; ++pos) out.emplace_back(std::move(*pos));
+        }
+
+        m_data.swap(merged);
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace detail
+} // namespace cfds
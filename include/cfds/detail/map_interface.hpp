@@ -0,0 +1,85 @@
+// Contains map_interface<Table> which adds the members that maps have on top
+// of sets, i.e. operator[], at, try_emplace and insert_or_assign, to a table
+// of std::pair<Key, T>. Table is detail::flat_tree or detail::dense_table
+// which both provide find() together with emplace_unique(key, args...)
+// constructing the element from args unless the key is already present.
+
+#pragma once
+
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace cfds {
+namespace detail {
+
+template <typename Table>
+class map_interface : public Table {
+ public:
+    using mapped_type = typename Table::value_type::second_type;
+    using typename Table::const_iterator;
+    using typename Table::iterator;
+    using typename Table::key_type;
+
+    using Table::Table;
+
+    map_interface() = default;
+
+    mapped_type& operator[](const key_type& key) {
+        return try_emplace(key).first->second;
+    }
+
+    mapped_type& operator[](key_type&& key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+
+    mapped_type& at(const key_type& key) {
+        iterator pos = this->find(key);
+        if (pos == this->end()) throw std::out_of_range("");
+        return pos->second;
+    }
+
+    const mapped_type& at(const key_type& key) const {
+        const_iterator pos = this->find(key);
+        if (pos == this->end()) throw std::out_of_range("");
+        return pos->second;
+    }
+
+    // The mapped value is only constructed from args when the key is missing.
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& key,
+                                          Args&&... args) {
+        return this->emplace_unique(
+            key, std::piecewise_construct, std::forward_as_tuple(key),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+        return this->emplace_unique(
+            key, std::piecewise_construct,
+            std::forward_as_tuple(std::move(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj) {
+        std::pair<iterator, bool> result =
+            try_emplace(key, std::forward<M>(obj));
+        if (!result.second) result.first->second = std::forward<M>(obj);
+
+        return result;
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj) {
+        std::pair<iterator, bool> result =
+            try_emplace(std::move(key), std::forward<M>(obj));
+        if (!result.second) result.first->second = std::forward<M>(obj);
+
+        return result;
+    }
+};
+
+} // namespace detail
+} // namespace cfds
@@ -0,0 +1,104 @@
+// Contains small_vector_base which implements the buffer management of
+// small_vector_header<T> for trivially relocatable elements stored in blocks
+// from malloc, i.e. with malloc_allocator<T> or aligned_allocator<T, N>.
+// Since such elements are moved around with std::memcpy they're only
+// described by byte sizes here, which lets every element type share the same
+// code instead of instantiating it for every T, like SmallVectorBase in LLVM.
+//
+// The functions are kept out of line so that a program contains them once.
+// Sizes and offsets are given in bytes and alignment is the alignment of the
+// heap blocks, see safe_malloc().
+
+#pragma once
+
+#include "utility.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace cfds {
+namespace detail {
+
+class small_vector_base {
+ public:
+    // Returns a block of new_cap bytes holding the size bytes at data. Heap
+    // blocks are resized with std::realloc which may extend them in place.
+    CFDS_NOINLINE static void* grow(void* data, std::size_t size,
+                                    std::size_t new_cap, bool heap,
+                                    std::size_t alignment) {
+        if (heap) return safe_realloc(data, size, new_cap, alignment);
+
+        void* block = safe_malloc(new_cap, alignment);
+        copy(block, data, size);
+        return block;
+    }
+
+    // Like grow() but leaves gap uninitialized bytes at offset, the bytes
+    // after offset are copied once to their final location.
+    CFDS_NOINLINE static void* grow_with_gap(void* data, std::size_t size,
+                                             std::size_t new_cap,
+                                             std::size_t offset,
+                                             std::size_t gap, bool heap,
+                                             std::size_t alignment) {
+        if (offset == size) return grow(data, size, new_cap, heap, alignment);
+
+        char* block = static_cast<char*>(safe_malloc(new_cap, alignment));
+        const char* bytes = static_cast<const char*>(data);
+
+        copy(block, bytes, offset);
+        copy(block + offset + gap, bytes + offset, size - offset);
+
+        if (heap) aligned_free(data, alignment);
+
+        return block;
+    }
+
+    // Moves the size bytes of the heap block at data into small when it's
+    // not null and otherwise into a block of new_cap bytes, which is returned.
+    CFDS_NOINLINE static void* shrink(void* data, std::size_t size,
+                                      std::size_t new_cap, void* small,
+                                      std::size_t alignment) {
+        if (small == nullptr) {
+            return safe_realloc(data, size, new_cap, alignment);
+        }
+
+        copy(small, data, size);
+        aligned_free(data, alignment);
+        return small;
+    }
+
+    // Exchanges bytes bytes between x and y through a small scratch buffer.
+    // The fixed size blocks let the compiler turn the copies into a few
+    // vector loads and stores.
+    CFDS_NOINLINE static void swap(void* x, void* y,
+                                   std::size_t bytes) noexcept {
+        const std::size_t block = 32;
+        unsigned char scratch[block];
+        unsigned char* first = static_cast<unsigned char*>(x);
+        unsigned char* second = static_cast<unsigned char*>(y);
+
+        for (; bytes >= block; bytes -= block) {
+            std::memcpy(scratch, first, block);
+            std::memcpy(first, second, block);
+            std::memcpy(second, scratch, block);
+            first += block;
+            second += block;
+        }
+
+        if (bytes > 0) {
+            std::memcpy(scratch, first, bytes);
+            std::memcpy(first, second, bytes);
+            std::memcpy(second, scratch, bytes);
+        }
+    }
+
+ private:
+    // std::memcpy requires valid pointers even when nothing is copied.
+    static void copy(void* dest, const void* src, std::size_t size) noexcept {
+        if (size > 0) std::memcpy(dest, src, size);
+    }
+};
+
+} // namespace detail
+} // namespace cfds
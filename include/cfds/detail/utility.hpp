@@ -1,42 +1,68 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// Branch hints for the capacity checks and attributes keeping the rarely
+// taken paths, e.g. growing the buffer, out of the inlined fast paths.
+#if defined(__GNUC__) || defined(__clang__)
+#define CFDS_LIKELY(x) __builtin_expect(!!(x), 1)
+#define CFDS_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define CFDS_NOINLINE __attribute__((noinline))
+#define CFDS_COLD __attribute__((noinline, cold))
+#elif defined(_MSC_VER)
+#define CFDS_LIKELY(x) (x)
+#define CFDS_UNLIKELY(x) (x)
+#define CFDS_NOINLINE __declspec(noinline)
+#define CFDS_COLD __declspec(noinline)
+#else
+#define CFDS_LIKELY(x) (x)
+#define CFDS_UNLIKELY(x) (x)
+#define CFDS_NOINLINE
+#define CFDS_COLD
+#endif
+
 namespace cfds {
 namespace detail {
 
-template <typename T, int N>
-struct aligned_storage_base {
+// Inline buffer of N elements aligned to Alignment, which has to be at least
+// alignof(T).
+template <typename T, int N, std::size_t Alignment = alignof(T)>
+struct alignas(Alignment) aligned_storage_base {
     typename std::aligned_storage<sizeof(T), alignof(T)>::type buffer[N];
 };
 
 // aligned_storage_base<T, 0> has to be aligned as if it contained an internal
 // buffer so that the pointer arithmetic in
 // SmallDenseSetImpl<T>::getFirstSmallElement() will work.
-template <typename T>
-struct alignas(alignof(T)) aligned_storage_base<T, 0> {};
-
-template <typename T>
-struct aligned_storage_base_alignment {
-    T padding;
-    typename std::aligned_storage<sizeof(T), alignof(T)>::type buffer;
-};
+template <typename T, std::size_t Alignment>
+struct alignas(Alignment) aligned_storage_base<T, 0, Alignment> {};
 
-// Returns a pointer to the first element of the inline buffer by
-// calculating the offset from the this pointer and the buffer member.
-template <typename T>
+// Returns a pointer to the first element of the inline buffer following
+// container, which the compiler places at the first multiple of Alignment
+// after the container since its members leave no tail padding behind.
+template <std::size_t Alignment = 1, typename T>
 inline void* get_buffer_address(T* container) {
-    std::size_t offset = reinterpret_cast<std::size_t>(
-        &(reinterpret_cast<aligned_storage_base_alignment<T>*>(0)->buffer));
+    std::size_t offset = (sizeof(T) + Alignment - 1) / Alignment * Alignment;
 
     return const_cast<void*>(reinterpret_cast<const void*>(
         reinterpret_cast<const char*>(container) + offset));
 }
 
 // Returns the next power of two starting from n, if n is a power of two the
-// return value will still be the next power of two.
+// return value will still be the next power of two. Saturates at the maximum
+// value of std::uint64_t instead of wrapping around to 0.
 inline std::uint64_t next_power_of_two(std::uint64_t number) {
     number |= (number >> 1);
     number |= (number >> 2);
@@ -44,7 +70,17 @@ inline std::uint64_t next_power_of_two(std::uint64_t number) {
     number |= (number >> 8);
     number |= (number >> 16);
     number |= (number >> 32);
-    return number + 1;
+    return number == std::numeric_limits<std::uint64_t>::max() ? number
+                                                               : number + 1;
+}
+
+// Converts number to SizeType, clamping it to the maximum value of SizeType.
+template <typename SizeType>
+SizeType saturate_cast(std::uint64_t number) {
+    using unsigned_type = typename std::make_unsigned<SizeType>::type;
+    std::uint64_t max = static_cast<unsigned_type>(
+        std::numeric_limits<SizeType>::max());
+    return static_cast<SizeType>(number < max ? number : max);
 }
 
 // Malloc which throws std::bad_alloc if allocation fails.
@@ -54,5 +90,73 @@ inline void* safe_malloc(std::size_t size) {
     return data;
 }
 
+constexpr bool is_over_aligned(std::size_t alignment) {
+    return alignment > alignof(std::max_align_t);
+}
+
+// Malloc returning memory aligned to alignment which has to be a power of
+// two. Over-aligned blocks come from the aligned allocation function of the
+// platform and have to be released with aligned_free.
+inline void* safe_malloc(std::size_t size, std::size_t alignment) {
+    if (!is_over_aligned(alignment)) return safe_malloc(size);
+
+#if defined(_WIN32)
+    void* data = ::_aligned_malloc(size, alignment);
+#else
+    void* data = nullptr;
+    if (::posix_memalign(&data, alignment, size) != 0) data = nullptr;
+#endif
+
+    if (data == nullptr) throw std::bad_alloc();
+    return data;
+}
+
+inline void aligned_free(void* ptr, std::size_t alignment) noexcept {
+#if defined(_WIN32)
+    if (is_over_aligned(alignment)) {
+        ::_aligned_free(ptr);
+        return;
+    }
+#else
+    static_cast<void>(alignment);
+#endif
+
+    std::free(ptr);
+}
+
+// Realloc keeping the block aligned to alignment. std::realloc only
+// guarantees the fundamental alignment so over-aligned blocks are copied to a
+// new block instead. The block is left untouched if the allocation fails.
+inline void* safe_realloc(void* ptr, std::size_t old_size,
+                          std::size_t new_size, std::size_t alignment) {
+    if (!is_over_aligned(alignment)) {
+        void* data = std::realloc(ptr, new_size);
+        if (data == nullptr) throw std::bad_alloc();
+        return data;
+    }
+
+    void* data = safe_malloc(new_size, alignment);
+    std::memcpy(data, ptr, old_size < new_size ? old_size : new_size);
+    aligned_free(ptr, alignment);
+    return data;
+}
+
+// Extract the key from the elements of the associative containers, which are
+// either the keys themselves or key-value pairs.
+struct key_of_identity {
+    template <typename T>
+    const T& operator()(const T& value) const noexcept {
+        return value;
+    }
+};
+
+struct key_of_pair {
+    template <typename Pair>
+    const typename Pair::first_type& operator()(const Pair& value) const
+        noexcept {
+        return value.first;
+    }
+};
+
 } // namespace detail
 } // namespace cfds
@@ -0,0 +1,146 @@
+// Contains the growth policies which decides how much the capacity of a
+// container in cfds grows when it runs out of space. A growth policy is a type
+// with a static member function next_capacity(capacity, required) returning a
+// capacity greater or equal to required. The returned capacity is used for
+// push_back, insert and reserve alike.
+//
+// A policy may also declare use_usable_size as std::true_type to ask the
+// container to adopt the real size of every allocated block, as reported by
+// the allocators usable_size(ptr, count), as its capacity.
+//
+// A policy providing a static member function shrink_capacity(capacity, size)
+// makes the container release memory after erase, clear and pop_back. The
+// returned capacity is used when it's smaller than the current one, moving
+// the elements back into the small buffer when they fit.
+//
+// The arithmetic of the policies saturates at the maximum value of SizeType,
+// the container is responsible for clamping the result to its max_size().
+
+#pragma once
+
+#include "detail/utility.hpp"
+#include "meta.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace cfds {
+
+// Grows the capacity to the next power of two, this is the default policy.
+struct power_of_two_growth {
+    template <typename SizeType>
+    static SizeType next_capacity(SizeType capacity, SizeType required) {
+        SizeType next_pow = detail::saturate_cast<SizeType>(
+            detail::next_power_of_two(static_cast<std::uint64_t>(capacity)));
+        return std::max(required, next_pow);
+    }
+};
+
+// Grows the capacity by a factor of Numerator / Denominator, e.g. the default
+// factor_growth<> grows by 1.5x which trades a few more reallocations for less
+// unused capacity.
+template <int Numerator = 3, int Denominator = 2>
+struct factor_growth {
+    static_assert(Denominator > 0 && Numerator > Denominator,
+                  "factor_growth<Numerator, Denominator> requires a factor "
+                  "greater than 1.");
+
+    template <typename SizeType>
+    static SizeType next_capacity(SizeType capacity, SizeType required) {
+        std::uint64_t current = static_cast<std::uint64_t>(capacity);
+        std::uint64_t max = std::numeric_limits<std::uint64_t>::max();
+        std::uint64_t next = max;
+
+        if (current / Denominator <= max / Numerator) {
+            next = current / Denominator * Numerator +
+                   current % Denominator * Numerator / Denominator;
+        }
+
+        next = std::max(next, current + 1);
+        return std::max(required, detail::saturate_cast<SizeType>(next));
+    }
+};
+
+// Grows the capacity by Step elements at a time which keeps the unused
+// capacity bounded at the cost of linear reallocation behaviour.
+template <int Step>
+struct fixed_step_growth {
+    static_assert(Step > 0, "fixed_step_growth<Step> requires Step to be "
+                            "greater than 0.");
+
+    template <typename SizeType>
+    static SizeType next_capacity(SizeType capacity, SizeType required) {
+        std::uint64_t next = static_cast<std::uint64_t>(capacity) + Step;
+        return std::max(required, detail::saturate_cast<SizeType>(next));
+    }
+};
+
+// Grows the capacity according to Policy and then rounds it up to whatever
+// the allocator actually handed out, using malloc_usable_size for
+// malloc_allocator, so that the slack of the allocators size classes is put
+// to use instead of being wasted.
+template <typename Policy = power_of_two_growth>
+struct size_class_growth {
+    using use_usable_size = std::true_type;
+
+    template <typename SizeType>
+    static SizeType next_capacity(SizeType capacity, SizeType required) {
+        return Policy::next_capacity(capacity, required);
+    }
+};
+
+namespace detail {
+
+template <typename Policy>
+auto use_usable_size_impl(meta::priority_tag<1>)
+    -> meta::bool_constant<Policy::use_usable_size::value>;
+
+template <typename Policy>
+auto use_usable_size_impl(meta::priority_tag<0>) -> std::false_type;
+
+template <typename Policy>
+struct use_usable_size
+    : decltype(use_usable_size_impl<Policy>(meta::priority_tag<1>{})) {};
+
+template <typename Policy, typename SizeType>
+auto has_shrink_capacity_impl(meta::priority_tag<1>)
+    -> decltype(Policy::shrink_capacity(SizeType{}, SizeType{}),
+                std::true_type{});
+
+template <typename Policy, typename SizeType>
+auto has_shrink_capacity_impl(meta::priority_tag<0>) -> std::false_type;
+
+template <typename Policy, typename SizeType>
+struct has_shrink_capacity
+    : decltype(has_shrink_capacity_impl<Policy, SizeType>(
+          meta::priority_tag<1>{})) {};
+
+} // namespace detail
+
+// Grows according to Policy and shrinks the capacity to twice the size once
+// the size has dropped to 1 / Ratio of the capacity. The gap between the two
+// thresholds keeps a container which oscillates around a size from
+// reallocating on every insertion and erasure.
+template <typename Policy = power_of_two_growth, int Ratio = 4>
+struct hysteresis_growth {
+    static_assert(Ratio > 2, "hysteresis_growth<Policy, Ratio> requires Ratio "
+                             "to be greater than 2.");
+
+    using use_usable_size =
+        meta::bool_constant<detail::use_usable_size<Policy>::value>;
+
+    template <typename SizeType>
+    static SizeType next_capacity(SizeType capacity, SizeType required) {
+        return Policy::next_capacity(capacity, required);
+    }
+
+    template <typename SizeType>
+    static SizeType shrink_capacity(SizeType capacity, SizeType size) {
+        if (size > capacity / Ratio) return capacity;
+        return static_cast<SizeType>(size * 2);
+    }
+};
+
+} // namespace cfds
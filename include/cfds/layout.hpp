@@ -0,0 +1,221 @@
+// Contains the layouts which decides how small_vector_header<T> stores the
+// location of its elements. A layout is a tag type with a nested size_type,
+// the actual members are provided by detail::header_storage<T, Layout>.
+//
+// basic_pointer_layout<SizeType> stores begin, end and end of capacity as three
+// pointers which keeps begin(), end() and the capacity check of push_back free
+// of arithmetic. basic_compact_layout<SizeType> stores a pointer together with
+// the size and capacity as SizeType, which with a 32-bit SizeType makes the
+// header 16 bytes instead of 24 on 64-bit platforms.
+//
+// pointer_layout and compact_layout use int as size_type while large_layout
+// uses std::size_t for containers with more than 2^31 - 1 elements.
+//
+// The header storage also tells where the small buffer of the container is.
+// By default it's the inline buffer placed right after the header, while
+// external_buffer_layout<Layout> stores the location and capacity of a buffer
+// provided by the caller next to the members of Layout.
+// stored_capacity_layout<Layout> keeps the inline buffer but remembers its
+// capacity, so that a header on the heap can return to its inline buffer
+// without knowing N, e.g. the moved from string in small_string_header.
+
+#pragma once
+
+#include "detail/utility.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace cfds {
+
+template <typename SizeType>
+struct basic_pointer_layout {
+    static_assert(std::is_integral<SizeType>::value,
+                  "basic_pointer_layout<SizeType> requires SizeType to be an "
+                  "integral type.");
+
+    using size_type = SizeType;
+};
+
+template <typename SizeType>
+struct basic_compact_layout {
+    static_assert(std::is_integral<SizeType>::value,
+                  "basic_compact_layout<SizeType> requires SizeType to be an "
+                  "integral type.");
+
+    using size_type = SizeType;
+};
+
+template <typename Layout>
+struct external_buffer_layout {
+    using size_type = typename Layout::size_type;
+};
+
+template <typename Layout>
+struct stored_capacity_layout {
+    using size_type = typename Layout::size_type;
+};
+
+using pointer_layout = basic_pointer_layout<int>;
+using compact_layout = basic_compact_layout<int>;
+using large_layout = basic_pointer_layout<std::size_t>;
+
+namespace detail {
+
+template <typename T, typename Layout>
+class header_storage;
+
+// The small buffer is the inline buffer following the owner of the storage,
+// aligned to Owner::alignment. Its capacity isn't known here so it's reported
+// as 0.
+template <typename T, typename SizeType>
+class inline_buffer_storage {
+ public:
+    template <typename Owner>
+    static T* small_buffer(Owner* owner) noexcept {
+        return static_cast<T*>(
+            get_buffer_address<Owner::alignment>(owner));
+    }
+
+    static SizeType small_capacity() noexcept { return 0; }
+};
+
+// Remembers the capacity of the small buffer for containers which need it
+// after spilling, e.g. to shrink back into it, and is empty otherwise.
+template <typename SizeType, bool Enabled>
+class small_capacity_holder {
+ public:
+    explicit small_capacity_holder(SizeType) noexcept {}
+};
+
+template <typename SizeType>
+class small_capacity_holder<SizeType, true> {
+ public:
+    explicit small_capacity_holder(SizeType capacity) noexcept
+        : m_small_capacity(capacity) {}
+
+    SizeType stored_small_capacity() const noexcept {
+        return m_small_capacity;
+    }
+
+ private:
+    SizeType m_small_capacity;
+};
+
+template <typename T, typename SizeType>
+class header_storage<T, basic_pointer_layout<SizeType>>
+    : public inline_buffer_storage<T, SizeType> {
+ public:
+    using pointer = T*;
+    using size_type = SizeType;
+
+    header_storage(pointer begin, size_type capacity) noexcept
+        : m_begin(begin), m_end(begin), m_end_cap(begin + capacity) {}
+
+    pointer begin() const noexcept { return m_begin; }
+    pointer end() const noexcept { return m_end; }
+
+    size_type size() const noexcept {
+        return static_cast<size_type>(m_end - m_begin);
+    }
+
+    size_type capacity() const noexcept {
+        return static_cast<size_type>(m_end_cap - m_begin);
+    }
+
+    bool full() const noexcept { return m_end == m_end_cap; }
+
+    void set_end(pointer end) noexcept { m_end = end; }
+
+    void reset(pointer begin, size_type size, size_type capacity) noexcept {
+        m_begin = begin;
+        m_end = begin + size;
+        m_end_cap = begin + capacity;
+    }
+
+ private:
+    pointer m_begin;
+    pointer m_end;
+    pointer m_end_cap;
+};
+
+template <typename T, typename SizeType>
+class header_storage<T, basic_compact_layout<SizeType>>
+    : public inline_buffer_storage<T, SizeType> {
+ public:
+    using pointer = T*;
+    using size_type = SizeType;
+
+    header_storage(pointer begin, size_type capacity) noexcept
+        : m_begin(begin), m_size(0), m_capacity(capacity) {}
+
+    pointer begin() const noexcept { return m_begin; }
+    pointer end() const noexcept { return m_begin + m_size; }
+
+    size_type size() const noexcept { return m_size; }
+    size_type capacity() const noexcept { return m_capacity; }
+
+    bool full() const noexcept { return m_size == m_capacity; }
+
+    void set_end(pointer end) noexcept {
+        m_size = static_cast<size_type>(end - m_begin);
+    }
+
+    void reset(pointer begin, size_type size, size_type capacity) noexcept {
+        m_begin = begin;
+        m_size = size;
+        m_capacity = capacity;
+    }
+
+ private:
+    pointer m_begin;
+    size_type m_size;
+    size_type m_capacity;
+};
+
+template <typename T, typename Layout>
+class header_storage<T, external_buffer_layout<Layout>>
+    : public header_storage<T, Layout> {
+    using base_type = header_storage<T, Layout>;
+
+ public:
+    using pointer = T*;
+    using size_type = typename Layout::size_type;
+
+    header_storage(pointer begin, size_type capacity) noexcept
+        : base_type(begin, capacity), m_small(begin),
+          m_small_capacity(capacity) {}
+
+    template <typename Owner>
+    pointer small_buffer(Owner*) const noexcept {
+        return m_small;
+    }
+
+    size_type small_capacity() const noexcept { return m_small_capacity; }
+
+ private:
+    pointer m_small;
+    size_type m_small_capacity;
+};
+
+template <typename T, typename Layout>
+class header_storage<T, stored_capacity_layout<Layout>>
+    : public header_storage<T, Layout> {
+    using base_type = header_storage<T, Layout>;
+
+ public:
+    using pointer = T*;
+    using size_type = typename Layout::size_type;
+
+    header_storage(pointer begin, size_type capacity) noexcept
+        : base_type(begin, capacity), m_small_capacity(capacity) {}
+
+    size_type small_capacity() const noexcept { return m_small_capacity; }
+
+ private:
+    size_type m_small_capacity;
+};
+
+} // namespace detail
+} // namespace cfds
@@ -1,9 +1,84 @@
+// Contains the type traits used by the containers in cfds, most notably
+// is_trivially_relocatable<T> which tells whether objects of type T can be
+// moved to another address with std::memcpy without running their move
+// constructor and destructor.
+//
+// A type is considered trivially relocatable when it's trivially move
+// constructible and destructible, when the compiler says so through
+// __is_trivially_relocatable, e.g. for [[clang::trivial_abi]] types, when it
+// has a nested is_trivially_relocatable type with a true value or when it's
+// declared as such with CFDS_TRIVIALLY_RELOCATABLE(T) at global scope.
+// Standard library types are only specialized for implementations whose
+// layout has been checked to never point into the object itself, which rules
+// out e.g. std::string of libstdc++ because of its short string buffer.
+
 #pragma once
 
 #include <cstddef>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<optional>) &&                                              \
+    ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
+#include <optional>
+#define CFDS_HAS_OPTIONAL 1
+#endif
+#endif
+
+#ifndef CFDS_HAS_OPTIONAL
+#define CFDS_HAS_OPTIONAL 0
+#endif
+
+#if defined(__has_builtin)
+#if __has_builtin(__is_trivially_relocatable)
+#define CFDS_BUILTIN_TRIVIALLY_RELOCATABLE(T) __is_trivially_relocatable(T)
+#endif
+#endif
+
+#ifndef CFDS_BUILTIN_TRIVIALLY_RELOCATABLE
+#define CFDS_BUILTIN_TRIVIALLY_RELOCATABLE(T) false
+#endif
+
+// The debug modes of the standard libraries keep track of the iterators of
+// a container which refer back to the container.
+#if defined(_GLIBCXX_DEBUG) || defined(_LIBCPP_DEBUG) ||                       \
+    defined(_LIBCPP_ENABLE_DEBUG_MODE)
+#define CFDS_STD_DEBUG 1
+#else
+#define CFDS_STD_DEBUG 0
+#endif
+
+// libc++ poisons the unused part of the short string buffer under
+// AddressSanitizer which std::memcpy would then read.
+#if defined(__SANITIZE_ADDRESS__)
+#define CFDS_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define CFDS_ASAN 1
+#endif
+#endif
+
+#ifndef CFDS_ASAN
+#define CFDS_ASAN 0
+#endif
+
+// Declares the type given as argument as trivially relocatable, it has to be
+// used at global scope. Extra arguments are part of the type which lets it
+// take types containing commas, e.g. CFDS_TRIVIALLY_RELOCATABLE(map<K, V>).
+#define CFDS_TRIVIALLY_RELOCATABLE(...)                                       \
+    namespace cfds {                                                           \
+    namespace meta {                                                           \
+    template <>                                                                \
+    struct is_trivially_relocatable<__VA_ARGS__> : std::true_type {};          \
+    }                                                                          \
+    }
 
 namespace cfds {
 namespace meta {
@@ -25,8 +100,18 @@ auto is_trivially_relocatable_impl(priority_tag<1>)
 
 template <typename T>
 auto is_trivially_relocatable_impl(priority_tag<0>)
-    -> bool_constant<std::is_trivially_move_constructible<T>::value &&
-                     std::is_trivially_destructible<T>::value>;
+    -> bool_constant<(std::is_trivially_move_constructible<T>::value &&
+                      std::is_trivially_destructible<T>::value) ||
+                     CFDS_BUILTIN_TRIVIALLY_RELOCATABLE(T)>;
+
+// Types without an iterator_category, e.g. allocators passed next to another
+// argument, are not iterators rather than a hard error.
+template <typename Iterator, typename Tag>
+auto has_iterator_category_impl(priority_tag<1>) -> std::is_base_of<
+    Tag, typename std::iterator_traits<Iterator>::iterator_category>;
+
+template <typename Iterator, typename Tag>
+auto has_iterator_category_impl(priority_tag<0>) -> std::false_type;
 
 } // namespace detail
 
@@ -43,17 +128,81 @@ struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
 template <typename T>
 struct is_trivially_relocatable<std::weak_ptr<T>> : std::true_type {};
 
+template <typename T, typename U>
+struct is_trivially_relocatable<std::pair<T, U>>
+    : bool_constant<is_trivially_relocatable<T>::value &&
+                    is_trivially_relocatable<U>::value> {};
+
+#if CFDS_HAS_OPTIONAL
+template <typename T>
+struct is_trivially_relocatable<std::optional<T>>
+    : is_trivially_relocatable<T> {};
+#endif
+
+template <typename T>
+struct is_trivially_relocatable<std::allocator<T>> : std::true_type {};
+
+#if (defined(__GLIBCXX__) || defined(_LIBCPP_VERSION)) && !CFDS_STD_DEBUG
+// Three pointers together with the allocator in both implementations.
+template <typename T, typename Allocator>
+struct is_trivially_relocatable<std::vector<T, Allocator>>
+    : is_trivially_relocatable<Allocator> {};
+#endif
+
+#if defined(__GLIBCXX__)
+// Small callables are only stored inline when they are trivially copyable.
+template <typename Signature>
+struct is_trivially_relocatable<std::function<Signature>> : std::true_type {};
+#endif
+
+#if defined(_LIBCPP_VERSION) && !CFDS_STD_DEBUG && !CFDS_ASAN
+// The short string is stored in place of the pointer rather than pointed to.
+template <typename Char, typename Traits, typename Allocator>
+struct is_trivially_relocatable<std::basic_string<Char, Traits, Allocator>>
+    : is_trivially_relocatable<Allocator> {};
+#endif
+
+// Customization point for relocating an object, i.e. moving it into
+// uninitialized memory and ending the lifetime of the source. Types which
+// relocate cheaper than with a move followed by a destruction, e.g. by
+// copying their bytes and fixing up pointers into themselves, specialize it
+// as a std::true_type with a noexcept static relocate(T* src, T* dest).
+template <typename T, typename = void>
+struct relocate_traits : std::false_type {};
+
+template <typename T>
+struct is_nothrow_relocatable
+    : bool_constant<is_trivially_relocatable<T>::value ||
+                    relocate_traits<T>::value ||
+                    std::is_nothrow_move_constructible<T>::value> {};
+
+// Relocates the object at src into dest through relocate_traits<T> when it's
+// specialized and otherwise by moving and destroying the object.
+template <typename T>
+typename std::enable_if<relocate_traits<T>::value>::type
+relocate_at(T* src, T* dest) noexcept {
+    relocate_traits<T>::relocate(src, dest);
+}
+
+template <typename T>
+typename std::enable_if<!relocate_traits<T>::value>::type
+relocate_at(T* src, T* dest) noexcept(
+    std::is_nothrow_move_constructible<T>::value) {
+    ::new (static_cast<void*>(dest)) T(std::move(*src));
+    src->~T();
+}
+
 template <typename Iterator>
 struct is_input_iterator
-    : std::is_base_of<
-          std::input_iterator_tag,
-          typename std::iterator_traits<Iterator>::iterator_category> {};
+    : decltype(detail::has_iterator_category_impl<Iterator,
+                                                  std::input_iterator_tag>(
+          priority_tag<1>{})) {};
 
 template <typename Iterator>
 struct is_forward_iterator
-    : std::is_base_of<
-          std::forward_iterator_tag,
-          typename std::iterator_traits<Iterator>::iterator_category> {};
+    : decltype(detail::has_iterator_category_impl<Iterator,
+                                                  std::forward_iterator_tag>(
+          priority_tag<1>{})) {};
 
 } // namespace meta
 } // namespace cfds
@@ -0,0 +1,50 @@
+// Contains the definition of small_dense_map<Key, T, N> which is a hash map
+// keeping a table of N slots inline, N being a power of two, and moving to a
+// heap table once it's 7/8 full, see detail/dense_table.hpp. A map holding at
+// most 14 elements thereby never allocates with the default N of 16.
+//
+// The elements are std::pair<Key, T> rather than std::pair<const Key, T> so
+// that they can be relocated when rehashing, modifying a key through an
+// iterator is undefined. Inserting may invalidate all iterators while erasing
+// only invalidates iterators to the erased element.
+
+#pragma once
+
+#include "detail/dense_table.hpp"
+#include "detail/map_interface.hpp"
+#include "detail/utility.hpp"
+
+#include <functional>
+#include <initializer_list>
+#include <utility>
+
+namespace cfds {
+
+template <typename Key, typename T, int N = 16,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class small_dense_map
+    : public detail::map_interface<detail::dense_table<
+          Key, std::pair<Key, T>, detail::key_of_pair, Hash, KeyEqual, N>> {
+    using base_type = detail::map_interface<detail::dense_table<
+        Key, std::pair<Key, T>, detail::key_of_pair, Hash, KeyEqual, N>>;
+
+ public:
+    using base_type::base_type;
+
+    small_dense_map() = default;
+
+    small_dense_map& operator=(
+        std::initializer_list<typename base_type::value_type> ilist) {
+        base_type::operator=(ilist);
+        return *this;
+    }
+};
+
+template <typename Key, typename T, int N, typename Hash, typename KeyEqual>
+void swap(small_dense_map<Key, T, N, Hash, KeyEqual>& x,
+          small_dense_map<Key, T, N, Hash, KeyEqual>& y) noexcept {
+    x.swap(y);
+}
+
+} // namespace cfds
@@ -0,0 +1,42 @@
+// Contains the definition of small_dense_set<Key, N> which is a hash set
+// keeping a table of N slots inline, N being a power of two, and moving to a
+// heap table once it's 7/8 full, see detail/dense_table.hpp. Inserting may
+// invalidate all iterators while erasing only invalidates iterators to the
+// erased element.
+
+#pragma once
+
+#include "detail/dense_table.hpp"
+#include "detail/utility.hpp"
+
+#include <functional>
+#include <initializer_list>
+
+namespace cfds {
+
+template <typename Key, int N = 16, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class small_dense_set
+    : public detail::dense_table<Key, Key, detail::key_of_identity, Hash,
+                                 KeyEqual, N> {
+    using base_type = detail::dense_table<Key, Key, detail::key_of_identity,
+                                          Hash, KeyEqual, N>;
+
+ public:
+    using base_type::base_type;
+
+    small_dense_set() = default;
+
+    small_dense_set& operator=(std::initializer_list<Key> ilist) {
+        base_type::operator=(ilist);
+        return *this;
+    }
+};
+
+template <typename Key, int N, typename Hash, typename KeyEqual>
+void swap(small_dense_set<Key, N, Hash, KeyEqual>& x,
+          small_dense_set<Key, N, Hash, KeyEqual>& y) noexcept {
+    x.swap(y);
+}
+
+} // namespace cfds
@@ -0,0 +1,47 @@
+// Contains the definition of small_flat_map<Key, T, N> which keeps its
+// key-value pairs sorted by key in a small_vector, holding up to N of them
+// inline. Tiny maps thereby cost no allocation at all and lookups only touch
+// a single contiguous block, see detail/flat_tree.hpp.
+//
+// Like other flat maps the elements are std::pair<Key, T> rather than
+// std::pair<const Key, T> so that they can be moved around, modifying a key
+// through an iterator is undefined. Inserting and erasing invalidate all
+// iterators and move the elements after the position.
+
+#pragma once
+
+#include "detail/flat_tree.hpp"
+#include "detail/map_interface.hpp"
+
+#include <functional>
+#include <utility>
+
+namespace cfds {
+
+template <typename Key, typename T, int N = 4,
+          typename Compare = std::less<Key>>
+class small_flat_map
+    : public detail::map_interface<detail::flat_tree<
+          Key, std::pair<Key, T>, detail::key_of_pair, Compare, N>> {
+    using base_type = detail::map_interface<detail::flat_tree<
+        Key, std::pair<Key, T>, detail::key_of_pair, Compare, N>>;
+
+ public:
+    using base_type::base_type;
+
+    small_flat_map() = default;
+
+    small_flat_map& operator=(
+        std::initializer_list<typename base_type::value_type> ilist) {
+        base_type::operator=(ilist);
+        return *this;
+    }
+};
+
+template <typename Key, typename T, int N, typename Compare>
+void swap(small_flat_map<Key, T, N, Compare>& x,
+          small_flat_map<Key, T, N, Compare>& y) {
+    x.swap(y);
+}
+
+} // namespace cfds
@@ -0,0 +1,37 @@
+// Contains the definition of small_flat_set<Key, N> which keeps its keys
+// sorted in a small_vector, holding up to N of them inline, see
+// detail/flat_tree.hpp. Inserting and erasing invalidate all iterators and
+// move the elements after the position.
+
+#pragma once
+
+#include "detail/flat_tree.hpp"
+
+#include <functional>
+
+namespace cfds {
+
+template <typename Key, int N = 4, typename Compare = std::less<Key>>
+class small_flat_set
+    : public detail::flat_tree<Key, Key, detail::key_of_identity, Compare, N> {
+    using base_type =
+        detail::flat_tree<Key, Key, detail::key_of_identity, Compare, N>;
+
+ public:
+    using base_type::base_type;
+
+    small_flat_set() = default;
+
+    small_flat_set& operator=(std::initializer_list<Key> ilist) {
+        base_type::operator=(ilist);
+        return *this;
+    }
+};
+
+template <typename Key, int N, typename Compare>
+void swap(small_flat_set<Key, N, Compare>& x,
+          small_flat_set<Key, N, Compare>& y) {
+    x.swap(y);
+}
+
+} // namespace cfds
@@ -0,0 +1,513 @@
+// Contains the definition of small_ring<T, N> which is a double ended queue
+// storing up to N elements inline in the same way as small_vector<T, N>. The
+// elements wrap around the end of the buffer so pushing and popping at either
+// end is O(1) rather than shifting the elements like small_vector::erase.
+//
+// Once the inline buffer is full the elements move to a heap buffer whose
+// capacity is a power of two, and trivially relocatable elements are moved
+// around with std::memcpy. The elements are at most split in two contiguous
+// segments, see segments(), which can be handed to code taking a pointer and
+// a size, e.g. writev or a parser. Pushing may invalidate all iterators.
+
+#pragma once
+
+#include "meta.hpp"
+
+#include "detail/bulk.hpp"
+#include "detail/utility.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace cfds {
+namespace detail {
+
+// Random access iterator holding the ring and a position relative to its
+// front, Ring is const for const iterators.
+template <typename Ring, typename T>
+class ring_iterator {
+ public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename std::remove_const<T>::type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    ring_iterator() = default;
+
+    ring_iterator(Ring* ring, difference_type index) noexcept
+        : m_ring(ring), m_index(index) {}
+
+    template <typename OtherRing, typename U,
+              typename = typename std::enable_if<
+                  !std::is_same<U, T>::value &&
+                  std::is_same<const U, T>::value>::type>
+    ring_iterator(const ring_iterator<OtherRing, U>& other) noexcept
+        : m_ring(other.m_ring), m_index(other.m_index) {}
+
+    reference operator*() const { return (*m_ring)[m_index]; }
+    pointer operator->() const { return &(*m_ring)[m_index]; }
+
+    reference operator[](difference_type offset) const {
+        return (*m_ring)[m_index + offset];
+    }
+
+    ring_iterator& operator++() noexcept {
+        ++m_index;
+        return *this;
+    }
+
+    ring_iterator operator++(int) noexcept {
+        ring_iterator copy = *this;
+        ++m_index;
+        return copy;
+    }
+
+    ring_iterator& operator--() noexcept {
+        --m_index;
+        return *this;
+    }
+
+    ring_iterator operator--(int) noexcept {
+        ring_iterator copy = *this;
+        --m_index;
+        return copy;
+    }
+
+    ring_iterator& operator+=(difference_type offset) noexcept {
+        m_index += offset;
+        return *this;
+    }
+
+    ring_iterator& operator-=(difference_type offset) noexcept {
+        m_index -= offset;
+        return *this;
+    }
+
+    friend ring_iterator operator+(ring_iterator iter,
+                                   difference_type offset) noexcept {
+        return iter += offset;
+    }
+
+    friend ring_iterator operator+(difference_type offset,
+                                   ring_iterator iter) noexcept {
+        return iter += offset;
+    }
+
+    friend ring_iterator operator-(ring_iterator iter,
+                                   difference_type offset) noexcept {
+        return iter -= offset;
+    }
+
+    friend difference_type operator-(const ring_iterator& x,
+                                     const ring_iterator& y) noexcept {
+        return x.m_index - y.m_index;
+    }
+
+    friend bool operator==(const ring_iterator& x,
+                           const ring_iterator& y) noexcept {
+        return x.m_index == y.m_index;
+    }
+
+    friend bool operator!=(const ring_iterator& x,
+                           const ring_iterator& y) noexcept {
+        return x.m_index != y.m_index;
+    }
+
+    friend bool operator<(const ring_iterator& x,
+                          const ring_iterator& y) noexcept {
+        return x.m_index < y.m_index;
+    }
+
+    friend bool operator>(const ring_iterator& x,
+                          const ring_iterator& y) noexcept {
+        return y < x;
+    }
+
+    friend bool operator<=(const ring_iterator& x,
+                           const ring_iterator& y) noexcept {
+        return !(y < x);
+    }
+
+    friend bool operator>=(const ring_iterator& x,
+                           const ring_iterator& y) noexcept {
+        return !(x < y);
+    }
+
+ private:
+    template <typename, typename>
+    friend class ring_iterator;
+
+    Ring* m_ring = nullptr;
+    difference_type m_index = 0;
+};
+
+// A contiguous part of a ring.
+template <typename T>
+struct ring_segment {
+    T* first;
+    T* last;
+
+    T* begin() const noexcept { return first; }
+    T* end() const noexcept { return last; }
+    T* data() const noexcept { return first; }
+
+    std::size_t size() const noexcept {
+        return static_cast<std::size_t>(last - first);
+    }
+
+    bool empty() const noexcept { return first == last; }
+};
+
+} // namespace detail
+
+template <typename T, int N = 8>
+class small_ring : private detail::aligned_storage_base<T, N> {
+    static_assert(N >= 0,
+                  "small_ring<T, N> requires N to be greater or equal to 0.");
+
+    static_assert(meta::is_nothrow_relocatable<T>::value,
+                  "small_ring<T, N> requires T to be nothrow relocatable.");
+
+    using storage_type = detail::aligned_storage_base<T, N>;
+
+ public:
+    using value_type = T;
+    using size_type = int;
+    using difference_type = std::ptrdiff_t;
+
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+
+    using iterator = detail::ring_iterator<small_ring, T>;
+    using const_iterator = detail::ring_iterator<const small_ring, const T>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    using segment = detail::ring_segment<T>;
+    using const_segment = detail::ring_segment<const T>;
+
+    small_ring() noexcept
+        : m_data(small_buffer()), m_head(0), m_size(0), m_capacity(N) {}
+
+    template <typename InputIterator,
+              typename = typename std::enable_if<
+                  meta::is_input_iterator<InputIterator>::value>::type>
+    small_ring(InputIterator first, InputIterator last) : small_ring() {
+        for (; first != last; ++first) {
+            emplace_back(*first);
+        }
+    }
+
+    small_ring(std::initializer_list<T> ilist)
+        : small_ring(ilist.begin(), ilist.end()) {}
+
+    small_ring(const small_ring& other) : small_ring() {
+        reserve(other.size());
+        copy_elements(other);
+    }
+
+    // Never allocates since the heap buffer of other is stolen and inline
+    // elements fit in the inline buffer.
+    small_ring(small_ring&& other) noexcept : small_ring() {
+        take_elements(other);
+    }
+
+    ~small_ring() {
+        destroy_elements();
+        if (!is_small()) deallocate();
+    }
+
+    small_ring& operator=(const small_ring& other) {
+        if (this != &other) {
+            clear();
+            reserve(other.size());
+            copy_elements(other);
+        }
+
+        return *this;
+    }
+
+    small_ring& operator=(small_ring&& other) noexcept {
+        if (this != &other) {
+            release();
+            take_elements(other);
+        }
+
+        return *this;
+    }
+
+    small_ring& operator=(std::initializer_list<T> ilist) {
+        clear();
+        for (const T& value : ilist) {
+            emplace_back(value);
+        }
+
+        return *this;
+    }
+
+    iterator begin() noexcept { return iterator(this, 0); }
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    const_iterator cbegin() const noexcept { return begin(); }
+
+    iterator end() noexcept { return iterator(this, m_size); }
+    const_iterator end() const noexcept {
+        return const_iterator(this, m_size);
+    }
+    const_iterator cend() const noexcept { return end(); }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+    size_type size() const noexcept { return m_size; }
+    size_type capacity() const noexcept { return m_capacity; }
+    bool empty() const noexcept { return m_size == 0; }
+    bool is_small() const noexcept { return m_data == small_buffer(); }
+
+    // Heap capacities are powers of two.
+    size_type max_size() const noexcept {
+        std::size_t max = std::min<std::size_t>(
+            std::numeric_limits<size_type>::max() / 2 + 1,
+            std::numeric_limits<difference_type>::max() / sizeof(value_type));
+        return static_cast<size_type>(detail::next_power_of_two(max) / 2);
+    }
+
+    reference operator[](size_type index) { return *slot(index); }
+    const_reference operator[](size_type index) const {
+        return *slot(index);
+    }
+
+    reference at(size_type index) {
+        if (index < 0 || index >= m_size) throw std::out_of_range("");
+        return *slot(index);
+    }
+
+    const_reference at(size_type index) const {
+        if (index < 0 || index >= m_size) throw std::out_of_range("");
+        return *slot(index);
+    }
+
+    reference front() { return m_data[m_head]; }
+    const_reference front() const { return m_data[m_head]; }
+
+    reference back() { return *slot(m_size - 1); }
+    const_reference back() const { return *slot(m_size - 1); }
+
+    // The elements from the front up to the end of the buffer followed by
+    // the elements which wrapped around to the start of the buffer, the
+    // second segment is empty unless the elements wrap.
+    std::pair<segment, segment> segments() noexcept {
+        size_type count = std::min(m_size, m_capacity - m_head);
+        pointer head = m_data + m_head;
+
+        return {segment{head, head + count},
+                segment{m_data, m_data + (m_size - count)}};
+    }
+
+    std::pair<const_segment, const_segment> segments() const noexcept {
+        size_type count = std::min(m_size, m_capacity - m_head);
+        const_pointer head = m_data + m_head;
+
+        return {const_segment{head, head + count},
+                const_segment{m_data, m_data + (m_size - count)}};
+    }
+
+    void reserve(size_type count) {
+        if (count > m_capacity) grow(count);
+    }
+
+    template <typename... Args>
+    reference emplace_back(Args&&... args) {
+        if (CFDS_UNLIKELY(m_size == m_capacity)) grow(m_size + 1);
+
+        pointer pos = slot(m_size);
+        ::new (static_cast<void*>(pos)) value_type(std::forward<Args>(args)...);
+        ++m_size;
+
+        return *pos;
+    }
+
+    void push_back(const value_type& value) { emplace_back(value); }
+    void push_back(value_type&& value) { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    reference emplace_front(Args&&... args) {
+        if (CFDS_UNLIKELY(m_size == m_capacity)) grow(m_size + 1);
+
+        size_type head = m_head == 0 ? m_capacity - 1 : m_head - 1;
+        ::new (static_cast<void*>(m_data + head))
+            value_type(std::forward<Args>(args)...);
+        m_head = head;
+        ++m_size;
+
+        return m_data[head];
+    }
+
+    void push_front(const value_type& value) { emplace_front(value); }
+    void push_front(value_type&& value) { emplace_front(std::move(value)); }
+
+    void pop_back() {
+        slot(m_size - 1)->~value_type();
+        --m_size;
+    }
+
+    // The next element is pushed at the start of the buffer once the ring is
+    // empty, which keeps the elements of a queue that is drained in one
+    // segment.
+    void pop_front() {
+        m_data[m_head].~value_type();
+        --m_size;
+        m_head = m_size == 0 || m_head + 1 == m_capacity ? 0 : m_head + 1;
+    }
+
+    void clear() noexcept {
+        destroy_elements();
+        m_head = 0;
+        m_size = 0;
+    }
+
+    void swap(small_ring& other) noexcept {
+        small_ring tmp(std::move(other));
+        other.take_elements(*this);
+        take_elements(tmp);
+    }
+
+    friend bool operator==(const small_ring& x, const small_ring& y) {
+        return x.size() == y.size() &&
+               std::equal(x.begin(), x.end(), y.begin());
+    }
+
+    friend bool operator!=(const small_ring& x, const small_ring& y) {
+        return !(x == y);
+    }
+
+ private:
+    pointer m_data;
+    size_type m_head;
+    size_type m_size;
+    size_type m_capacity;
+
+    pointer small_buffer() noexcept {
+        return reinterpret_cast<pointer>(static_cast<storage_type*>(this));
+    }
+
+    const_pointer small_buffer() const noexcept {
+        return reinterpret_cast<const_pointer>(
+            static_cast<const storage_type*>(this));
+    }
+
+    // The element index steps from the front, wrapping around at the end of
+    // the buffer.
+    pointer slot(size_type index) const noexcept {
+        size_type pos = m_head + index;
+        if (pos >= m_capacity) pos -= m_capacity;
+        return m_data + pos;
+    }
+
+    // Relocates the elements to the start of a heap buffer holding at least
+    // count elements.
+    CFDS_NOINLINE void grow(size_type count) {
+        if (count > max_size()) throw_length_error();
+
+        std::size_t capacity = detail::next_power_of_two(
+            static_cast<std::uint64_t>(count) - 1);
+        pointer data = static_cast<pointer>(detail::safe_malloc(
+            sizeof(value_type) * capacity, alignof(value_type)));
+
+        std::pair<segment, segment> parts = segments();
+        detail::uninitialized_relocate(parts.first.first, parts.first.last,
+                                       data);
+        detail::uninitialized_relocate(parts.second.first, parts.second.last,
+                                       data + parts.first.size());
+
+        if (!is_small()) deallocate();
+
+        m_data = data;
+        m_head = 0;
+        m_capacity = static_cast<size_type>(capacity);
+    }
+
+    void deallocate() noexcept {
+        detail::aligned_free(m_data, alignof(value_type));
+    }
+
+    void destroy_elements() noexcept {
+        std::pair<segment, segment> parts = segments();
+        detail::destroy_range(parts.first.first, parts.first.last);
+        detail::destroy_range(parts.second.first, parts.second.last);
+    }
+
+    void release() noexcept {
+        destroy_elements();
+        if (!is_small()) deallocate();
+
+        m_data = small_buffer();
+        m_head = 0;
+        m_size = 0;
+        m_capacity = N;
+    }
+
+    void copy_elements(const small_ring& other) {
+        for (const T& value : other) {
+            emplace_back(value);
+        }
+    }
+
+    // Takes the elements of other, which is left empty, given that this
+    // ring is empty and inline. Inline elements are relocated to the start
+    // of the inline buffer.
+    void take_elements(small_ring& other) noexcept {
+        if (!other.is_small()) {
+            m_data = other.m_data;
+            m_head = other.m_head;
+            m_size = other.m_size;
+            m_capacity = other.m_capacity;
+
+            other.m_data = other.small_buffer();
+            other.m_head = 0;
+            other.m_size = 0;
+            other.m_capacity = N;
+            return;
+        }
+
+        std::pair<segment, segment> parts = other.segments();
+        detail::uninitialized_relocate(parts.first.first, parts.first.last,
+                                       m_data);
+        detail::uninitialized_relocate(parts.second.first, parts.second.last,
+                                       m_data + parts.first.size());
+
+        m_size = other.m_size;
+        other.m_head = 0;
+        other.m_size = 0;
+    }
+
+    [[noreturn]] CFDS_COLD static void throw_length_error() {
+        throw std::length_error("cfds::small_ring exceeded max_size()");
+    }
+};
+
+template <typename T, int N>
+void swap(small_ring<T, N>& x, small_ring<T, N>& y) noexcept {
+    x.swap(y);
+}
+
+} // namespace cfds
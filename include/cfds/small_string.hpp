@@ -0,0 +1,602 @@
+// Contains the definitions of small_string<N> and small_string_header which
+// are null terminated strings of char storing up to N characters inline, on
+// top of small_vector_header<char>. The terminator is kept as the last element
+// of the underlying vector so that growing and relocating the buffer goes
+// through the same code as small_vector<char, N + 1>. The header remembers
+// the capacity of the inline buffer, see stored_capacity_layout, so a moved
+// from string goes back to its inline buffer without allocating.
+//
+// small_string_header can't be instantiated but type erases N in the same way
+// as small_vector_header<T>, i.e. void f(small_string_header& s) can take any
+// small_string<N>. Strings convert to std::string_view when it's available.
+
+#pragma once
+
+#include "small_vector.hpp"
+
+#include "detail/utility.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(__has_include)
+#if __has_include(<string_view>) &&                                            \
+    ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
+#include <string_view>
+#define CFDS_HAS_STRING_VIEW 1
+#endif
+#endif
+
+#ifndef CFDS_HAS_STRING_VIEW
+#define CFDS_HAS_STRING_VIEW 0
+#endif
+
+namespace cfds {
+namespace detail {
+
+// Lets small_string_header define npos in a header under C++11, where a
+// static data member which is odr-used needs a single definition.
+template <typename = void>
+struct string_npos {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+};
+
+template <typename Tag>
+constexpr std::size_t string_npos<Tag>::npos;
+
+using string_vector_header = small_vector_header<char, malloc_allocator<char>,
+                                                 power_of_two_growth,
+                                                 stored_capacity_layout<
+                                                     large_layout>>;
+
+} // namespace detail
+
+class small_string_header : private detail::string_vector_header,
+                            public detail::string_npos<> {
+    using base_type = detail::string_vector_header;
+
+ public:
+    using traits_type = std::char_traits<char>;
+    using value_type = char;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using reference = char&;
+    using const_reference = const char&;
+    using pointer = char*;
+    using const_pointer = const char*;
+
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    iterator begin() noexcept { return base_type::begin(); }
+    const_iterator begin() const noexcept { return base_type::begin(); }
+    const_iterator cbegin() const noexcept { return begin(); }
+
+    iterator end() noexcept { return base_type::end() - 1; }
+    const_iterator end() const noexcept { return base_type::end() - 1; }
+    const_iterator cend() const noexcept { return end(); }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+    size_type size() const noexcept { return base_type::size() - 1; }
+    size_type length() const noexcept { return size(); }
+    bool empty() const noexcept { return size() == 0; }
+
+    // The terminator takes up one element of the underlying vector.
+    size_type capacity() const noexcept { return base_type::capacity() - 1; }
+    size_type max_size() const noexcept { return base_type::max_size() - 1; }
+
+    using base_type::is_small;
+
+    char* data() noexcept { return base_type::data(); }
+    const char* data() const noexcept { return base_type::data(); }
+    const char* c_str() const noexcept { return data(); }
+
+    char& operator[](size_type index) { return data()[index]; }
+    const char& operator[](size_type index) const { return data()[index]; }
+
+    char& at(size_type index) {
+        if (index >= size()) throw std::out_of_range("");
+        return data()[index];
+    }
+
+    const char& at(size_type index) const {
+        if (index >= size()) throw std::out_of_range("");
+        return data()[index];
+    }
+
+    char& front() { return *begin(); }
+    const char& front() const { return *begin(); }
+
+    char& back() { return *(end() - 1); }
+    const char& back() const { return *(end() - 1); }
+
+#if CFDS_HAS_STRING_VIEW
+    operator std::string_view() const noexcept {
+        return std::string_view(data(), size());
+    }
+#endif
+
+    explicit operator std::string() const {
+        return std::string(data(), size());
+    }
+
+    void reserve(size_type count) {
+        if (count > max_size()) throw_length_error();
+        base_type::reserve(count + 1);
+    }
+
+    // Moves the characters back into the inline buffer when they fit.
+    void shrink_to_fit() { base_type::shrink_to_fit(); }
+
+    // Keeps the buffer but makes the string empty.
+    void clear() noexcept {
+        base_type::resize(1);
+        *data() = '\0';
+    }
+
+    void push_back(char ch) {
+        base_type::back() = ch;
+        base_type::push_back('\0');
+    }
+
+    void pop_back() {
+        base_type::pop_back();
+        base_type::back() = '\0';
+    }
+
+    void resize(size_type count, char ch = '\0') {
+        if (count > size()) {
+            append(count - size(), ch);
+            return;
+        }
+
+        base_type::resize(count + 1);
+        data()[count] = '\0';
+    }
+
+    // The characters may be part of this string.
+    small_string_header& assign(const char* s, size_type count) {
+        if (count > capacity()) {
+            base_type::clear();
+            reserve(count);
+        }
+
+        base_type::resize_for_overwrite(count + 1);
+        traits_type::move(data(), s, count);
+        data()[count] = '\0';
+
+        return *this;
+    }
+
+    small_string_header& assign(const char* s) {
+        return assign(s, traits_type::length(s));
+    }
+
+    small_string_header& assign(size_type count, char ch) {
+        clear();
+        return append(count, ch);
+    }
+
+    small_string_header& assign(const std::string& str) {
+        return assign(str.data(), str.size());
+    }
+
+    // The characters may be part of this string, in which case they're
+    // located again after the buffer has grown.
+    small_string_header& append(const char* s, size_type count) {
+        if (CFDS_UNLIKELY(count > capacity() - size())) {
+            s = grow_for_append(s, count);
+        }
+
+        char* dest = base_type::append_uninitialized(count) - 1;
+        traits_type::copy(dest, s, count);
+        dest[count] = '\0';
+
+        return *this;
+    }
+
+    small_string_header& append(const char* s) {
+        return append(s, traits_type::length(s));
+    }
+
+    small_string_header& append(size_type count, char ch) {
+        if (count > max_size() - size()) throw_length_error();
+
+        char* dest = base_type::append_uninitialized(count) - 1;
+        traits_type::assign(dest, count, ch);
+        dest[count] = '\0';
+
+        return *this;
+    }
+
+    small_string_header& append(const small_string_header& str) {
+        return append(str.data(), str.size());
+    }
+
+    small_string_header& append(const std::string& str) {
+        return append(str.data(), str.size());
+    }
+
+#if CFDS_HAS_STRING_VIEW
+    small_string_header& append(std::string_view str) {
+        return append(str.data(), str.size());
+    }
+#endif
+
+    small_string_header& operator+=(char ch) {
+        push_back(ch);
+        return *this;
+    }
+
+    small_string_header& operator+=(const char* s) { return append(s); }
+
+    small_string_header& operator+=(const small_string_header& str) {
+        return append(str);
+    }
+
+    small_string_header& operator+=(const std::string& str) {
+        return append(str);
+    }
+
+#if CFDS_HAS_STRING_VIEW
+    small_string_header& operator+=(std::string_view str) {
+        return append(str);
+    }
+#endif
+
+    small_string_header& erase(size_type index = 0, size_type count = npos) {
+        if (index > size()) throw std::out_of_range("");
+
+        count = std::min(count, size() - index);
+        base_type::erase(begin() + index, begin() + index + count);
+
+        return *this;
+    }
+
+    iterator erase(const_iterator pos) {
+        return base_type::erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        return base_type::erase(first, last);
+    }
+
+    int compare(const char* s, size_type count) const noexcept {
+        int result = traits_type::compare(data(), s, std::min(size(), count));
+        if (result != 0) return result;
+
+        return size() < count ? -1 : (size() > count ? 1 : 0);
+    }
+
+    int compare(const char* s) const noexcept {
+        return compare(s, traits_type::length(s));
+    }
+
+    int compare(const small_string_header& str) const noexcept {
+        return compare(str.data(), str.size());
+    }
+
+    size_type find(char ch, size_type pos = 0) const noexcept {
+        if (pos >= size()) return npos;
+
+        const char* found = traits_type::find(data() + pos, size() - pos, ch);
+        return found != nullptr ? static_cast<size_type>(found - data())
+                                : npos;
+    }
+
+    size_type find(const char* s, size_type pos, size_type count) const
+        noexcept {
+        if (pos > size() || count > size() - pos) return npos;
+        if (count == 0) return pos;
+
+        const char* last = data() + size() - count + 1;
+
+        for (const char* iter = data() + pos; iter != last; ++iter) {
+            iter = traits_type::find(iter, static_cast<size_type>(last - iter),
+                                     *s);
+            if (iter == nullptr) return npos;
+
+            if (traits_type::compare(iter, s, count) == 0) {
+                return static_cast<size_type>(iter - data());
+            }
+        }
+
+        return npos;
+    }
+
+    size_type find(const char* s, size_type pos = 0) const noexcept {
+        return find(s, pos, traits_type::length(s));
+    }
+
+    size_type find(const small_string_header& str, size_type pos = 0) const
+        noexcept {
+        return find(str.data(), pos, str.size());
+    }
+
+    size_type rfind(char ch, size_type pos = npos) const noexcept {
+        if (empty()) return npos;
+
+        for (size_type i = std::min(pos, size() - 1) + 1; i != 0; --i) {
+            if (data()[i - 1] == ch) return i - 1;
+        }
+
+        return npos;
+    }
+
+    void swap(small_string_header& other) { base_type::swap(other); }
+
+    small_string_header& operator=(const small_string_header& other) {
+        base_type::operator=(other);
+        return *this;
+    }
+
+    small_string_header& operator=(small_string_header&& other) {
+        if (this == &other) return *this;
+
+        base_type::operator=(std::move(other));
+        other.init_empty();
+
+        return *this;
+    }
+
+    small_string_header& operator=(const char* s) { return assign(s); }
+
+    small_string_header& operator=(const std::string& str) {
+        return assign(str);
+    }
+
+#if CFDS_HAS_STRING_VIEW
+    small_string_header& operator=(std::string_view str) {
+        return assign(str.data(), str.size());
+    }
+#endif
+
+    friend bool operator==(const small_string_header& x,
+                           const small_string_header& y) noexcept {
+        return x.size() == y.size() &&
+               traits_type::compare(x.data(), y.data(), x.size()) == 0;
+    }
+
+    friend bool operator==(const small_string_header& x,
+                           const char* y) noexcept {
+        return x.compare(y) == 0;
+    }
+
+    friend bool operator==(const char* x,
+                           const small_string_header& y) noexcept {
+        return y.compare(x) == 0;
+    }
+
+    friend bool operator==(const small_string_header& x,
+                           const std::string& y) noexcept {
+        return x.compare(y.data(), y.size()) == 0;
+    }
+
+    friend bool operator==(const std::string& x,
+                           const small_string_header& y) noexcept {
+        return y.compare(x.data(), x.size()) == 0;
+    }
+
+    friend bool operator!=(const small_string_header& x,
+                           const small_string_header& y) noexcept {
+        return !(x == y);
+    }
+
+    friend bool operator!=(const small_string_header& x,
+                           const char* y) noexcept {
+        return !(x == y);
+    }
+
+    friend bool operator!=(const char* x,
+                           const small_string_header& y) noexcept {
+        return !(x == y);
+    }
+
+    friend bool operator!=(const small_string_header& x,
+                           const std::string& y) noexcept {
+        return !(x == y);
+    }
+
+    friend bool operator!=(const std::string& x,
+                           const small_string_header& y) noexcept {
+        return !(x == y);
+    }
+
+    friend bool operator<(const small_string_header& x,
+                          const small_string_header& y) noexcept {
+        return x.compare(y) < 0;
+    }
+
+    friend bool operator>(const small_string_header& x,
+                          const small_string_header& y) noexcept {
+        return y < x;
+    }
+
+    friend bool operator<=(const small_string_header& x,
+                           const small_string_header& y) noexcept {
+        return !(y < x);
+    }
+
+    friend bool operator>=(const small_string_header& x,
+                           const small_string_header& y) noexcept {
+        return !(x < y);
+    }
+
+ protected:
+    // Requires init_empty() to be called once the inline buffer of
+    // inline_capacity elements, terminator included, has been constructed.
+    explicit small_string_header(size_type inline_capacity) noexcept
+        : base_type(inline_capacity) {}
+
+    small_string_header() = delete;
+    small_string_header(const small_string_header&) = delete;
+    small_string_header(small_string_header&&) = delete;
+
+    void init_empty() noexcept { base_type::emplace_back('\0'); }
+
+ private:
+    template <typename, typename>
+    friend struct meta::relocate_traits;
+
+    // Reserves room for count more characters and returns where s ended up,
+    // s is assumed to be part of this string if it points into the buffer.
+    CFDS_NOINLINE const char* grow_for_append(const char* s, size_type count) {
+        if (count > max_size() - size()) throw_length_error();
+
+        std::less_equal<const char*> before;
+        bool inside = before(data(), s) && before(s, data() + size());
+        size_type offset = static_cast<size_type>(s - data());
+
+        base_type::reserve(base_type::size() + count);
+
+        return inside ? data() + offset : s;
+    }
+
+    [[noreturn]] CFDS_COLD static void throw_length_error() {
+        throw std::length_error("cfds::small_string exceeded max_size()");
+    }
+};
+
+template <int N>
+class small_string
+    : public small_string_header,
+      private detail::aligned_storage_base<char, N + 1> {
+    static_assert(N >= 0,
+                  "small_string<N> requires N to be greater or equal to 0.");
+
+ public:
+    small_string() noexcept : small_string_header(N + 1) { init_empty(); }
+
+    small_string(const char* s, size_type count) : small_string() {
+        append(s, count);
+    }
+
+    small_string(const char* s) : small_string() { append(s); }
+
+    small_string(size_type count, char ch) : small_string() {
+        append(count, ch);
+    }
+
+    template <typename InputIterator,
+              typename = typename std::enable_if<
+                  meta::is_input_iterator<InputIterator>::value>::type>
+    small_string(InputIterator first, InputIterator last) : small_string() {
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+    small_string(std::initializer_list<char> ilist)
+        : small_string(ilist.begin(), ilist.size()) {}
+
+    small_string(const std::string& str)
+        : small_string(str.data(), str.size()) {}
+
+#if CFDS_HAS_STRING_VIEW
+    explicit small_string(std::string_view str)
+        : small_string(str.data(), str.size()) {}
+#endif
+
+    small_string(const small_string& other)
+        : small_string(other.data(), other.size()) {}
+
+    small_string(const small_string_header& other)
+        : small_string(other.data(), other.size()) {}
+
+    // Never allocates since the heap buffer of other is stolen and an inline
+    // string fits in the inline buffer.
+    small_string(small_string&& other) noexcept : small_string() {
+        small_string_header::operator=(std::move(other));
+    }
+
+    small_string(small_string_header&& other) : small_string() {
+        small_string_header::operator=(std::move(other));
+    }
+
+    small_string substr(size_type pos = 0, size_type count = npos) const {
+        if (pos > size()) throw std::out_of_range("");
+        return small_string(data() + pos, std::min(count, size() - pos));
+    }
+
+    small_string& operator=(const small_string& other) {
+        small_string_header::operator=(other);
+        return *this;
+    }
+
+    small_string& operator=(small_string&& other) {
+        small_string_header::operator=(std::move(other));
+        return *this;
+    }
+
+    small_string& operator=(const small_string_header& other) {
+        small_string_header::operator=(other);
+        return *this;
+    }
+
+    small_string& operator=(small_string_header&& other) {
+        small_string_header::operator=(std::move(other));
+        return *this;
+    }
+
+    small_string& operator=(const char* s) {
+        assign(s);
+        return *this;
+    }
+
+    small_string& operator=(const std::string& str) {
+        assign(str);
+        return *this;
+    }
+
+#if CFDS_HAS_STRING_VIEW
+    small_string& operator=(std::string_view str) {
+        assign(str.data(), str.size());
+        return *this;
+    }
+#endif
+};
+
+inline void swap(small_string_header& x, small_string_header& y) {
+    x.swap(y);
+}
+
+template <int N>
+void swap(small_string<N>& x, small_string<N>& y) {
+    x.swap(y);
+}
+
+namespace meta {
+
+// small_string relocates by copying its bytes like small_vector, see
+// small_vector_header::relocate.
+template <int N>
+struct relocate_traits<small_string<N>> : std::true_type {
+    static void relocate(small_string<N>* src, small_string<N>* dest) noexcept {
+        cfds::detail::string_vector_header::relocate(src, dest);
+    }
+};
+
+} // namespace meta
+
+} // namespace cfds
@@ -7,32 +7,71 @@
 // to type erase the inline size template paramater N from small_vector<T, N>.
 // i.e. void f(small_vector_header<T>& v) can take any small_vector<T, N> as
 // long as the T template parameter matches.
+//
+// Spilled buffers are obtained from the Allocator template parameter which
+// defaults to malloc_allocator<T>. cfds::pmr::small_vector<T, N> is provided
+// as an alias using std::pmr::polymorphic_allocator<T> when available and
+// arena_small_vector<T, N> as an alias spilling into a cfds::arena while
+// cached_small_vector<T, N> reuses spilled buffers of the same thread.
+// aligned_small_vector<T, N, Alignment> aligns both its inline buffer and its
+// heap buffers to Alignment bytes. How much the capacity grows when the vector
+// runs out of space is decided by the GrowthPolicy template parameter, see
+// growth_policy.hpp. The Layout template parameter decides how the header
+// stores its pointers, see layout.hpp.
 
 #pragma once
 
+#include "allocator.hpp"
+#include "arena.hpp"
+#include "growth_policy.hpp"
+#include "layout.hpp"
 #include "meta.hpp"
+#include "thread_cache.hpp"
 
-#include "detail/static_buffer.hpp"
+#include "detail/bulk.hpp"
+#include "detail/small_vector_base.hpp"
 #include "detail/utility.hpp"
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <initializer_list>
 #include <iterator>
 #include <limits>
 #include <memory>
 #include <new>
+#include <stdexcept>
 #include <type_traits>
 #include <utility>
 
 namespace cfds {
 
-template <typename T>
-class small_vector_header {
+template <typename T, typename Allocator = malloc_allocator<T>,
+          typename GrowthPolicy = power_of_two_growth,
+          typename Layout = pointer_layout>
+class small_vector_header
+    : private detail::allocator_holder<Allocator>,
+      private detail::small_capacity_holder<
+          typename Layout::size_type,
+          detail::has_shrink_capacity<GrowthPolicy,
+                                      typename Layout::size_type>::value> {
+    static_assert(std::is_same<typename Allocator::value_type, T>::value,
+                  "small_vector_header<T, Allocator> requires Allocator to "
+                  "allocate objects of type T.");
+
+    static_assert(
+        std::is_same<typename std::allocator_traits<Allocator>::pointer,
+                     T*>::value,
+        "small_vector_header<T, Allocator> requires Allocator to use raw "
+        "pointers.");
+
  public:
     using value_type = T;
-    using size_type = int;
+    using allocator_type = Allocator;
+    using growth_policy = GrowthPolicy;
+    using layout_type = Layout;
+    using size_type = typename Layout::size_type;
     using difference_type = std::ptrdiff_t;
 
     using reference = value_type&;
@@ -45,33 +84,50 @@ class small_vector_header {
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+    // data() is aligned to at least this many bytes both in the inline buffer
+    // and in heap buffers, see aligned_allocator<T, Alignment>.
+    static constexpr std::size_t alignment =
+        detail::allocator_alignment<Allocator>::value > alignof(T)
+            ? detail::allocator_alignment<Allocator>::value
+            : alignof(T);
+
     ~small_vector_header() {
-        if (!is_small()) std::free(m_begin);
+        if (!is_small()) deallocate(m_data.begin(), capacity());
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return this->allocator_ref();
     }
 
-    iterator begin() { return m_begin; }
-    const_iterator begin() const { return m_begin; }
-    const_iterator cbegin() const { return m_begin; }
+    iterator begin() { return m_data.begin(); }
+    const_iterator begin() const { return m_data.begin(); }
+    const_iterator cbegin() const { return m_data.begin(); }
 
-    iterator end() { return m_end; }
-    const_iterator end() const { return m_end; }
-    const_iterator cend() const { return m_end; }
+    iterator end() { return m_data.end(); }
+    const_iterator end() const { return m_data.end(); }
+    const_iterator cend() const { return m_data.end(); }
 
-    reverse_iterator rbegin() { return reverse_iterator(m_end); }
-    const_reverse_iterator rbegin() const { return reverse_iterator(m_end); }
-    const_reverse_iterator crbegin() const { return reverse_iterator(m_end); }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator crbegin() const {
+        return const_reverse_iterator(end());
+    }
 
-    reverse_iterator rend() { return reverse_iterator(m_begin); }
-    const_reverse_iterator rend() const { return reverse_iterator(m_begin); }
-    const_reverse_iterator crend() const { return reverse_iterator(m_begin); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crend() const {
+        return const_reverse_iterator(begin());
+    }
 
     void assign(size_type count, const value_type& value) {
-        clear();
+        erase_to_end(m_data.begin());
         reserve(count);
-
-        for (size_type i = 0; i < count; ++i) {
-            push_back(value);
-        }
+        detail::uninitialized_fill_n(m_data.begin(), count, value);
+        m_data.set_end(m_data.begin() + count);
     }
 
     template <typename InputIterator>
@@ -79,7 +135,7 @@ class small_vector_header {
         meta::is_input_iterator<InputIterator>::value &&
         !meta::is_forward_iterator<InputIterator>::value>::type
     assign(InputIterator first, InputIterator last) {
-        clear();
+        erase_to_end(m_data.begin());
 
         for (; first != last; ++first) {
             emplace_back(*first);
@@ -90,28 +146,24 @@ class small_vector_header {
     typename std::enable_if<
         meta::is_forward_iterator<ForwardIterator>::value>::type
     assign(ForwardIterator first, ForwardIterator last) {
-        clear();
-        reserve(std::distance(first, last));
+        auto count = static_cast<size_type>(std::distance(first, last));
 
-        for (; first != last; ++first) {
-            emplace_back(*first);
-        }
+        erase_to_end(m_data.begin());
+        reserve(count);
+        m_data.set_end(
+            detail::uninitialized_copy_n(first, count, m_data.begin()));
     }
 
     void assign(std::initializer_list<T> ilist) {
-        clear();
-        reserve(ilist.size());
-
-        for (auto&& element : ilist) {
-            emplace_back(element);
-        }
+        assign(ilist.begin(), ilist.end());
     }
 
     template <typename... Args>
     value_type& emplace_back(Args&&... args) {
-        if (m_end == m_end_cap) grow(capacity() + 1);
-        ::new (m_end++) value_type(std::forward<Args>(args)...);
-        return *(m_end - 1);
+        if (CFDS_UNLIKELY(m_data.full())) grow_by(1);
+        ::new (m_data.end()) value_type(std::forward<Args>(args)...);
+        m_data.set_end(m_data.end() + 1);
+        return *(m_data.end() - 1);
     }
 
     void push_back(const value_type& value) {
@@ -121,59 +173,130 @@ class small_vector_header {
     void push_back(value_type&& value) { emplace_back(std::move(value)); }
 
     void pop_back() {
-        destroy_range(m_end - 1, m_end);
-        --m_end;
+        erase_to_end(m_data.end() - 1);
+        shrink_after_erase(auto_shrink{});
     }
 
     void resize(size_type count) {
         if (count < size()) {
-            destroy_range(m_begin + count, m_end);
-            m_end = m_begin + count;
+            destroy_range(m_data.begin() + count, m_data.end());
+            m_data.set_end(m_data.begin() + count);
             return;
         }
 
         if (count > size()) {
             reserve(count);
-
-            for (int i = size(); i < count; ++i) {
-                emplace_back(value_type{});
-            }
+            value_construct_end(count);
         }
     }
 
-    void resize(size_type count, const value_type& value) {
+    // Same as resize(count) except that new elements are default initialized
+    // instead of value initialized, which leaves trivial types such as int
+    // uninitialized. Useful when the elements are overwritten right away.
+    void resize_for_overwrite(size_type count) {
         if (count < size()) {
-            destroy_range(m_begin + count, m_end);
-            m_end = m_begin + count;
+            destroy_range(m_data.begin() + count, m_data.end());
+            m_data.set_end(m_data.begin() + count);
             return;
         }
 
         if (count > size()) {
             reserve(count);
+            default_construct_end(
+                count,
+                typename std::is_trivially_default_constructible<T>::type{});
+        }
+    }
 
-            for (int i = size(); i < count; ++i) {
-                push_back(value);
-            }
+    // Appends count uninitialized elements and returns a pointer to the first
+    // of them so that they can be written to directly, e.g. by read(). Only
+    // available for types where leaving the elements uninitialized is valid.
+    template <typename U = T>
+    typename std::enable_if<std::is_trivially_default_constructible<U>::value &&
+                                std::is_trivially_destructible<U>::value,
+                            pointer>::type
+    append_uninitialized(size_type count) {
+        if (CFDS_UNLIKELY(count > capacity() - size())) grow_by(count);
+
+        pointer first = m_data.end();
+        m_data.set_end(first + count);
+
+        return first;
+    }
+
+    // Appends elements without checking the capacity, which lets fill loops
+    // keep the end of the vector in a register. The size of the vector is
+    // updated when the appender is destroyed, see back_inserter_unchecked().
+    class unchecked_appender {
+     public:
+        unchecked_appender(unchecked_appender&& other) noexcept
+            : m_vector(other.m_vector), m_end(other.m_end) {
+            other.m_vector = nullptr;
         }
+
+        unchecked_appender(const unchecked_appender&) = delete;
+        unchecked_appender& operator=(const unchecked_appender&) = delete;
+
+        ~unchecked_appender() {
+            if (m_vector != nullptr) m_vector->m_data.set_end(m_end);
+        }
+
+        template <typename... Args>
+        reference emplace_back(Args&&... args) {
+            ::new (m_end) value_type(std::forward<Args>(args)...);
+            return *m_end++;
+        }
+
+        void push_back(const value_type& value) { emplace_back(value); }
+        void push_back(value_type&& value) { emplace_back(std::move(value)); }
+
+     private:
+        friend class small_vector_header;
+
+        explicit unchecked_appender(small_vector_header& vector) noexcept
+            : m_vector(&vector), m_end(vector.m_data.end()) {}
+
+        small_vector_header* m_vector;
+        pointer m_end;
+    };
+
+    // Reserves room for count more elements which can then be appended
+    // through the returned appender. Appending more than count elements or
+    // using the vector before the appender is destroyed is undefined.
+    unchecked_appender back_inserter_unchecked(size_type count) {
+        if (CFDS_UNLIKELY(count > capacity() - size())) grow_by(count);
+        return unchecked_appender(*this);
     }
 
-    void swap(small_vector_header& other) {
-        if (this == &other) return;
+    // Appends count elements constructed from the results of calling gen.
+    // The elements appended before an exception are kept.
+    template <typename Generator>
+    void emplace_back_n(size_type count, Generator gen) {
+        unchecked_appender out = back_inserter_unchecked(count);
 
-        if (!is_small() && !other.is_small()) {
-            using std::swap;
-            swap(m_begin, other.m_begin);
-            swap(m_end_cap, other.m_end_cap);
-            swap(m_end, other.m_end);
-            return;
+        for (size_type i = 0; i < count; ++i) {
+            out.emplace_back(gen());
         }
+    }
 
-        if (size() > other.size()) {
-            slow_swap(*this, other);
+    void resize(size_type count, const value_type& value) {
+        if (count < size()) {
+            destroy_range(m_data.begin() + count, m_data.end());
+            m_data.set_end(m_data.begin() + count);
             return;
         }
 
-        slow_swap(other, *this);
+        if (count > size()) {
+            reserve(count);
+            detail::uninitialized_fill_n(m_data.end(), count - size(), value);
+            m_data.set_end(m_data.begin() + count);
+        }
+    }
+
+    // Heap buffers can only be exchanged when both vectors are able to free
+    // the others memory, otherwise the elements are swapped one by one.
+    void swap(small_vector_header& other) {
+        swap_impl(other, small_capacity(), other.small_capacity());
     }
 
     template <typename... Args>
@@ -197,48 +320,46 @@ class small_vector_header {
     iterator insert(const_iterator pos, size_type count,
                     const value_type& value) {
         iterator iter = make_space(pos, count);
-
-        for (size_type i = 0; i < count; ++i) {
-            insert_at_pos(iter + i, value);
-        }
+        detail::uninitialized_fill_n(iter, count, value);
 
         return iter;
     }
 
     // Overload of insert with iterators that has the iterator_category
     // std::input_iterator_tag. Input iterators are single pass so we cant
-    // calculate the distance between first and last before insertion.
+    // calculate the distance between first and last before insertion, instead
+    // the elements are appended into the spare capacity and rotated into place.
     template <typename InputIterator>
     typename std::enable_if<
         meta::is_input_iterator<InputIterator>::value &&
             !meta::is_forward_iterator<InputIterator>::value,
         iterator>::type
     insert(const_iterator pos, InputIterator first, InputIterator last) {
-        int index = static_cast<int>(pos - m_begin);
-        detail::static_buffer<value_type> buffer(&m_begin[index], m_end);
+        size_type index = static_cast<size_type>(pos - m_data.begin());
+        size_type old_size = size();
 
-        destroy_range(&m_begin[index], m_end);
-        m_end = &m_begin[index];
-
-        for (auto iter = first; iter != last; ++iter) {
-            push_back(*iter);
+        try {
+            for (; first != last; ++first) {
+                emplace_back(*first);
+            }
+        } catch (...) {
+            erase_to_end(m_data.begin() + old_size);
+            throw;
         }
 
-        insert(m_end, buffer.begin(), buffer.end());
+        std::rotate(m_data.begin() + index, m_data.begin() + old_size,
+                    m_data.end());
 
-        return &m_begin[index];
+        return m_data.begin() + index;
     }
 
     template <typename ForwardIterator>
     typename std::enable_if<meta::is_forward_iterator<ForwardIterator>::value,
                             iterator>::type
     insert(const_iterator pos, ForwardIterator first, ForwardIterator last) {
-        int count = std::distance(first, last);
+        auto count = static_cast<size_type>(std::distance(first, last));
         iterator iter = make_space(pos, count);
-
-        for (size_type i = 0; i < count; ++i, (void)++first) {
-            insert_at_pos(iter + i, *first);
-        }
+        detail::uninitialized_copy_n(first, count, iter);
 
         return iter;
     }
@@ -248,70 +369,60 @@ class small_vector_header {
         return insert(pos, std::begin(ilist), std::end(ilist));
     }
 
-    value_type& back() { return *(m_end - 1); }
-    const value_type& back() const { return *(m_end - 1); }
+    value_type& back() { return *(m_data.end() - 1); }
+    const value_type& back() const { return *(m_data.end() - 1); }
 
-    value_type& front() { return *m_begin; }
-    const value_type& front() const { return *m_begin; }
+    value_type& front() { return *m_data.begin(); }
+    const value_type& front() const { return *m_data.begin(); }
 
-    value_type& operator[](int index) { return *(m_begin + index); }
-    const value_type& operator[](int index) const { return *(m_begin + index); }
+    value_type& operator[](size_type index) {
+        return *(m_data.begin() + index);
+    }
+    const value_type& operator[](size_type index) const {
+        return *(m_data.begin() + index);
+    }
 
-    value_type& at(int index) {
+    value_type& at(size_type index) {
         if (index >= size()) throw std::out_of_range("");
         return (*this)[index];
     }
 
-    const value_type& at(int index) const {
+    const value_type& at(size_type index) const {
         if (index >= size()) throw std::out_of_range("");
         return (*this)[index];
     }
 
-    void reserve(int size) {
+    void reserve(size_type size) {
         if (size > capacity()) grow(size);
     }
 
-    pointer data() noexcept { return m_begin; }
-    const_pointer data() const noexcept { return m_begin; }
+    pointer data() noexcept { return m_data.begin(); }
+    const_pointer data() const noexcept { return m_data.begin(); }
 
+    // Bounded by size_type, the allocator and the largest number of elements
+    // whose byte size fits in difference_type.
     size_type max_size() const noexcept {
-        return std::min<size_type>(std::numeric_limits<size_type>::max(),
-                                   std::numeric_limits<difference_type>::max());
+        std::uintmax_t max = std::min<std::uintmax_t>(
+            std::numeric_limits<size_type>::max(),
+            std::numeric_limits<difference_type>::max() / sizeof(value_type));
+        max = std::min<std::uintmax_t>(
+            max, alloc_traits::max_size(this->allocator_ref()));
+        return static_cast<size_type>(max);
     }
 
-    size_type size() const noexcept { return m_end - m_begin; }
-    size_type capacity() const noexcept { return m_end_cap - m_begin; }
-    bool empty() const noexcept { return m_begin == m_end; }
-
-    void shrink_to_fit() {
-        if (is_small() || size() == capacity()) return;
-
-        if (size() == 0) {
-            std::free(m_begin);
-            m_begin = m_end = m_end_cap = nullptr;
-            return;
-        }
-
-        pointer new_begin = static_cast<pointer>(
-            detail::safe_malloc(sizeof(value_type) * size()));
-
-        try {
-            uninitialized_relocate(m_begin, m_end, new_begin);
-        } catch (...) {
-            std::free(new_begin);
-            throw;
-        }
-
-        std::free(m_begin);
+    size_type size() const noexcept { return m_data.size(); }
+    size_type capacity() const noexcept { return m_data.capacity(); }
+    bool empty() const noexcept { return size() == 0; }
 
-        m_end_cap = new_begin + size();
-        m_end = new_begin + size();
-        m_begin = new_begin;
-    }
+    // Moves the elements back into the small buffer when they fit and its
+    // capacity is known here, which is the case for external_small_vector<T>
+    // and growth policies that shrink, otherwise into a heap buffer matching
+    // the size. small_vector<T, N> always knows its inline capacity.
+    void shrink_to_fit() { shrink_to(size(), small_capacity()); }
 
     void clear() {
-        destroy_range(m_begin, m_end);
-        m_end = m_begin;
+        erase_to_end(m_data.begin());
+        shrink_after_erase(auto_shrink{});
     }
 
     iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
@@ -319,66 +430,75 @@ class small_vector_header {
     iterator erase(const_iterator first, const_iterator last) {
         if (first == last) return const_cast<iterator>(first);
 
+        size_type index = static_cast<size_type>(first - m_data.begin());
         destroy_range(first, last);
 
-        if (last != m_end) {
-            shift_data(last, m_end, const_cast<iterator>(first));
+        if (last != m_data.end()) {
+            detail::shift_data(last, m_data.end(), const_cast<iterator>(first));
         }
 
-        m_end -= last - first;
+        m_data.set_end(m_data.end() - (last - first));
+        shrink_after_erase(auto_shrink{});
 
-        return const_cast<iterator>(first);
+        return m_data.begin() + index;
     }
 
     // Returns whether the inlined buffer is currently in use to store the data.
     bool is_small() const {
-        return m_begin == detail::get_buffer_address(this);
+        return m_data.begin() == m_data.small_buffer(this);
     }
 
+    // The allocator is never propagated on copy assignment since the inline
+    // capacity of this vector isn't known here, which means that a heap buffer
+    // couldn't be released before switching allocator.
     small_vector_header& operator=(const small_vector_header& other) {
         if (this == &other) return *this;
 
         if (size() >= other.size()) {
             if (other.size() > 0) {
-                pointer head = std::copy(other.begin(), other.end(), begin());
+                pointer head =
+                    detail::copy_n(other.begin(), other.size(), begin());
                 destroy_range(head, end());
-                m_end = head;
+                m_data.set_end(head);
             } else {
-                clear();
+                erase_to_end(m_data.begin());
             }
 
             return *this;
         }
 
         if (capacity() < other.size()) {
-            clear();
+            erase_to_end(m_data.begin());
             grow(other.size());
         } else if (size() > 0) {
-            std::copy(other.begin(), other.begin() + size(), begin());
+            detail::copy_n(other.begin(), size(), begin());
         }
 
-        std::uninitialized_copy(other.begin() + size(), other.end(),
-                                begin() + size());
+        detail::uninitialized_copy_n(other.begin() + size(),
+                                     other.size() - size(), begin() + size());
 
-        m_end = m_begin + other.size();
+        m_data.set_end(m_data.begin() + other.size());
 
         return *this;
     }
 
+    // The heap buffer of other is stolen when this vector is allowed to free
+    // it, otherwise the elements are moved one by one.
     small_vector_header& operator=(small_vector_header&& other) {
         if (this == &other) return *this;
 
-        if (!other.is_small()) {
-            destroy_range(m_begin, m_end);
+        if (!other.is_small() &&
+            (propagate_on_move::value ||
+             this->allocator_ref() == other.allocator_ref())) {
+            destroy_range(m_data.begin(), m_data.end());
 
-            if (!is_small()) std::free(m_begin);
+            if (!is_small()) deallocate(m_data.begin(), capacity());
 
-            m_begin = other.m_begin;
-            m_end = other.m_end;
-            m_end_cap = other.m_end_cap;
+            move_allocator(other, propagate_on_move{});
 
-            other.m_begin = other.m_end = other.m_end_cap =
-                static_cast<pointer>(detail::get_buffer_address(&other));
+            m_data.reset(other.m_data.begin(), other.size(), other.capacity());
+            other.m_data.reset(other.m_data.small_buffer(&other), 0,
+                               other.small_capacity());
 
             return *this;
         }
@@ -387,81 +507,320 @@ class small_vector_header {
             if (other.size() > 0) {
                 pointer head = std::move(other.begin(), other.end(), begin());
                 destroy_range(head, end());
-                m_end = head;
+                m_data.set_end(head);
             } else {
-                clear();
+                erase_to_end(m_data.begin());
             }
 
-            other.clear();
+            other.erase_to_end(other.m_data.begin());
 
             return *this;
         }
 
         if (capacity() < other.size()) {
-            clear();
+            erase_to_end(m_data.begin());
             grow(other.size());
         } else if (size() > 0) {
             std::move(other.begin(), other.begin() + size(), begin());
         }
 
-        uninitialized_move(other.begin() + size(), other.end(),
-                           begin() + size());
+        detail::uninitialized_move(other.begin() + size(), other.end(),
+                                   begin() + size());
 
-        m_end = m_begin + other.size();
-        other.clear();
+        m_data.set_end(m_data.begin() + other.size());
+        other.erase_to_end(other.m_data.begin());
 
         return *this;
     }
 
  protected:
-    small_vector_header(int n) noexcept
-        : m_begin(reinterpret_cast<pointer>(detail::get_buffer_address(this))),
-          m_end(m_begin), m_end_cap(m_begin + n) {}
+    small_vector_header(size_type n) noexcept
+        : small_capacity_holder(n),
+          m_data(static_cast<pointer>(
+                     detail::get_buffer_address<alignment>(this)),
+                 n) {}
+
+    small_vector_header(size_type n, const Allocator& alloc) noexcept
+        : detail::allocator_holder<Allocator>(alloc), small_capacity_holder(n),
+          m_data(static_cast<pointer>(
+                     detail::get_buffer_address<alignment>(this)),
+                 n) {}
+
+    // Uses buffer as the small buffer instead of the inline buffer, requires
+    // a Layout storing its location such as external_buffer_layout<Layout>.
+    small_vector_header(pointer buffer, size_type n,
+                        const Allocator& alloc) noexcept
+        : detail::allocator_holder<Allocator>(alloc), small_capacity_holder(n),
+          m_data(buffer, n) {}
+
+    // Swaps with other given the capacities of both small buffers, which are
+    // 0 when unknown. A heap buffer is handed over to a vector whose elements
+    // fit into the known small buffer of the other vector, otherwise the
+    // elements are swapped one by one.
+    void swap_impl(small_vector_header& other, size_type small_cap,
+                   size_type other_small_cap) {
+        if (this == &other) return;
+
+        bool exchange_buffers =
+            propagate_on_swap::value ||
+            this->allocator_ref() == other.allocator_ref();
+
+        if (exchange_buffers && !is_small() && !other.is_small()) {
+            swap_allocator(other, propagate_on_swap{});
+            swap_data(other);
+            return;
+        }
+
+        if (exchange_buffers && meta::is_nothrow_relocatable<T>::value) {
+            if (!is_small() && small_cap > 0 && other.size() <= small_cap) {
+                hand_over_buffer(other, small_cap);
+                return;
+            }
+
+            if (!other.is_small() && other_small_cap > 0 &&
+                size() <= other_small_cap) {
+                other.hand_over_buffer(*this, other_small_cap);
+                return;
+            }
+        }
+
+        if (size() > other.size()) {
+            slow_swap(*this, other);
+            return;
+        }
+
+        slow_swap(other, *this);
+    }
+
+    // Relocates the elements into the small buffer when size() is at most
+    // small_cap and otherwise into a heap buffer of new_cap elements, given
+    // that new_cap is smaller than the current capacity.
+    void shrink_to(size_type new_cap, size_type small_cap) {
+        if (is_small() || new_cap >= capacity()) return;
+        shrink_to(new_cap, small_cap, use_base{});
+    }
 
     small_vector_header() = delete;
     small_vector_header(const small_vector_header&) = delete;
     small_vector_header(small_vector_header&&) = delete;
 
-    // Turn destroy_range into a noop when T is trivially copyable.
-    template <typename U = T>
-    static typename std::enable_if<std::is_trivially_copyable<U>::value>::type
-    destroy_range(const_iterator, const_iterator) {}
+    static void destroy_range(const_iterator first,
+                              const_iterator last) noexcept {
+        detail::destroy_range(first, last);
+    }
 
-    template <typename U = T>
-    static typename std::enable_if<!std::is_trivially_copyable<U>::value>::type
-    destroy_range(const_iterator begin, const_iterator end) {
-        for (; begin != end; ++begin) {
-            begin->~value_type();
+ private:
+    template <typename, typename>
+    friend struct meta::relocate_traits;
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using propagate_on_move =
+        typename alloc_traits::propagate_on_container_move_assignment;
+    using propagate_on_swap =
+        typename alloc_traits::propagate_on_container_swap;
+
+    // Heap buffers are resized with the allocators reallocate when the
+    // elements can be moved around with std::memcpy.
+    using can_reallocate =
+        meta::bool_constant<meta::is_trivially_relocatable<T>::value &&
+                            detail::has_reallocate<Allocator>::value>;
+
+    // Buffers of elements which are moved around with std::memcpy and
+    // allocated with malloc are managed by the non-template small_vector_base
+    // so that every such T shares the same code.
+    using use_base = meta::bool_constant<
+        meta::is_trivially_relocatable<T>::value &&
+        detail::is_malloc_based_allocator<Allocator>::value>;
+
+    static constexpr std::size_t heap_alignment =
+        detail::allocator_alignment<Allocator>::value;
+
+    void shrink_to(size_type new_cap, size_type small_cap, std::true_type) {
+        size_type count = size();
+        bool to_small = count <= small_cap;
+        void* small = to_small ? m_data.small_buffer(this) : nullptr;
+
+        pointer new_begin =
+            static_cast<pointer>(detail::small_vector_base::shrink(
+                m_data.begin(), sizeof(value_type) * count,
+                sizeof(value_type) * new_cap, small, heap_alignment));
+
+        if (!to_small) {
+            new_cap = usable_capacity(new_begin, new_cap, use_usable_size{});
         }
+
+        m_data.reset(new_begin, count, to_small ? small_cap : new_cap);
     }
 
- private:
-    pointer m_begin = nullptr;
-    pointer m_end = nullptr;
-    pointer m_end_cap = nullptr;
+    void shrink_to(size_type new_cap, size_type small_cap, std::false_type) {
+        if (size() <= small_cap) {
+            pointer small = m_data.small_buffer(this);
+            size_type count = size();
+
+            if (count > 0) {
+                detail::uninitialized_relocate(
+                    m_data.begin(), m_data.begin() + count, small);
+            }
+
+            deallocate(m_data.begin(), capacity());
+            m_data.reset(small, count, small_cap);
+            return;
+        }
+
+        if (reallocate(new_cap, can_reallocate{})) return;
+
+        pointer new_begin = alloc_traits::allocate(this->allocator_ref(),
+                                                   new_cap);
+
+        try {
+            detail::uninitialized_relocate(m_data.begin(), m_data.end(),
+                                           new_begin);
+        } catch (...) {
+            deallocate(new_begin, new_cap);
+            throw;
+        }
+
+        deallocate(m_data.begin(), capacity());
+
+        m_data.reset(new_begin, size(), new_cap);
+    }
+
+    using use_usable_size =
+        meta::bool_constant<detail::use_usable_size<GrowthPolicy>::value &&
+                            detail::has_usable_size<Allocator>::value>;
+
+    // Memory is released after erasing when the growth policy asks for it.
+    using auto_shrink =
+        detail::has_shrink_capacity<GrowthPolicy, size_type>;
+
+    using small_capacity_holder =
+        detail::small_capacity_holder<size_type, auto_shrink::value>;
+
+    detail::header_storage<T, Layout> m_data;
+
+    void deallocate(pointer ptr, size_type count) noexcept {
+        alloc_traits::deallocate(this->allocator_ref(), ptr, count);
+    }
+
+    void erase_to_end(pointer pos) {
+        destroy_range(pos, m_data.end());
+        m_data.set_end(pos);
+    }
+
+    // The capacity of the small buffer when it's known, otherwise 0.
+    size_type small_capacity() const noexcept {
+        return small_capacity(auto_shrink{});
+    }
+
+    size_type small_capacity(std::true_type) const noexcept {
+        return this->stored_small_capacity();
+    }
+
+    size_type small_capacity(std::false_type) const noexcept {
+        return m_data.small_capacity();
+    }
+
+    // Shrinking is an optimization so the current buffer is kept if the
+    // elements can't be relocated.
+    void shrink_after_erase(std::true_type) noexcept {
+        if (is_small()) return;
+
+        size_type new_cap = GrowthPolicy::shrink_capacity(capacity(), size());
+        if (new_cap >= capacity()) return;
+
+        try {
+            shrink_to(std::max(new_cap, size()), small_capacity());
+        } catch (...) {
+        }
+    }
+
+    void shrink_after_erase(std::false_type) noexcept {}
+
+    void move_allocator(small_vector_header& other, std::true_type) noexcept {
+        this->allocator_ref() = std::move(other.allocator_ref());
+    }
+
+    void move_allocator(small_vector_header&, std::false_type) noexcept {}
+
+    void swap_allocator(small_vector_header& other, std::true_type) noexcept {
+        using std::swap;
+        swap(this->allocator_ref(), other.allocator_ref());
+    }
+
+    void swap_allocator(small_vector_header&, std::false_type) noexcept {}
+
+    // Exchanges the heap buffers while each vector keeps its small buffer.
+    void swap_data(small_vector_header& other) noexcept {
+        pointer begin = m_data.begin();
+        size_type count = size();
+        size_type cap = capacity();
+
+        m_data.reset(other.m_data.begin(), other.size(), other.capacity());
+        other.m_data.reset(begin, count, cap);
+    }
+
+    // Relocates the vector at src into dest by copying the header bytewise.
+    // Elements stored inline are relocated into the inline buffer of dest
+    // which the header is pointed at instead, see meta::relocate_traits.
+    static void relocate(small_vector_header* src,
+                         small_vector_header* dest) noexcept {
+        std::memcpy(static_cast<void*>(dest), static_cast<const void*>(src),
+                    sizeof(small_vector_header));
+
+        if (!src->is_small()) return;
+
+        pointer small = dest->m_data.small_buffer(dest);
+        detail::uninitialized_relocate(src->m_data.begin(),
+                                       src->m_data.end(), small);
+        dest->m_data.reset(small, src->size(), src->capacity());
+    }
+
+    // Gives the heap buffer of this vector to small, whose elements are
+    // relocated into the small buffer of this vector holding small_cap
+    // elements.
+    void hand_over_buffer(small_vector_header& small,
+                          size_type small_cap) noexcept {
+        pointer buffer = m_data.small_buffer(this);
+        size_type count = small.size();
+
+        detail::uninitialized_relocate(small.m_data.begin(),
+                                       small.m_data.end(), buffer);
+        swap_allocator(small, propagate_on_swap{});
+
+        small.m_data.reset(m_data.begin(), size(), capacity());
+        m_data.reset(buffer, count, small_cap);
+    }
 
     void slow_swap(small_vector_header& big, small_vector_header& small) {
         if (big.size() > small.capacity()) small.grow(big.size());
 
         size_type nr_shared = small.size();
 
-        for (size_type i = 0; i < nr_shared; ++i) {
-            using std::swap;
-            swap(big[i], small[i]);
-        }
+        swap_elements(big.m_data.begin(), small.m_data.begin(), nr_shared,
+                      typename meta::is_trivially_relocatable<T>::type{});
 
-        uninitialized_relocate(big.m_begin + nr_shared, big.m_end,
-                               small.m_begin + nr_shared);
+        detail::uninitialized_relocate(big.m_data.begin() + nr_shared,
+                                       big.m_data.end(),
+                                       small.m_data.begin() + nr_shared);
 
-        small.m_end = small.m_begin + big.size();
-        big.m_end = big.m_begin + nr_shared;
+        small.m_data.set_end(small.m_data.begin() + big.size());
+        big.m_data.set_end(big.m_data.begin() + nr_shared);
     }
 
-    template <typename InputIterator, typename ForwardIterator>
-    static void uninitialized_move(InputIterator first, InputIterator last,
-                                   ForwardIterator dest) {
-        std::uninitialized_copy(std::make_move_iterator(first),
-                                std::make_move_iterator(last), dest);
+    // Exchanges the bytes of the elements instead of running three moves per
+    // element.
+    static void swap_elements(pointer first, pointer second, size_type count,
+                              std::true_type) noexcept {
+        detail::small_vector_base::swap(first, second,
+                                        sizeof(value_type) * count);
+    }
+
+    static void swap_elements(pointer first, pointer second, size_type count,
+                              std::false_type) {
+        for (size_type i = 0; i < count; ++i) {
+            using std::swap;
+            swap(first[i], second[i]);
+        }
     }
 
     // Use memcpy instread of placement new when T is trivially copyable.
@@ -479,158 +838,303 @@ class small_vector_header {
 
     // Use memcpy instread of placement new when T is trivially copyable.
     void push_back_impl(const value_type& value, std::true_type) {
-        if (m_end == m_end_cap) grow(capacity() + 1);
-        std::memcpy(m_end++, std::addressof(value), sizeof(value_type));
+        if (CFDS_UNLIKELY(m_data.full())) grow_by(1);
+        std::memcpy(m_data.end(), std::addressof(value), sizeof(value_type));
+        m_data.set_end(m_data.end() + 1);
     }
 
     void push_back_impl(const value_type& value, std::false_type) {
         emplace_back(value);
     }
 
+    // Value initializes elements at the end until size() equals count. The
+    // size is only updated once when the constructor can't throw.
+    template <typename U = T>
+    typename std::enable_if<
+        std::is_nothrow_default_constructible<U>::value>::type
+    value_construct_end(size_type count) {
+        pointer last = m_data.begin() + count;
+
+        for (pointer iter = m_data.end(); iter != last; ++iter) {
+            ::new (static_cast<void*>(iter)) value_type();
+        }
+
+        m_data.set_end(last);
+    }
+
+    template <typename U = T>
+    typename std::enable_if<
+        !std::is_nothrow_default_constructible<U>::value>::type
+    value_construct_end(size_type count) {
+        pointer last = m_data.begin() + count;
+
+        for (pointer iter = m_data.end(); iter != last; ++iter) {
+            ::new (static_cast<void*>(iter)) value_type();
+            m_data.set_end(iter + 1);
+        }
+    }
+
+    // Default initialization is a noop for trivially default constructible
+    // types so only the size has to be updated.
+    void default_construct_end(size_type count, std::true_type) {
+        m_data.set_end(m_data.begin() + count);
+    }
+
+    void default_construct_end(size_type count, std::false_type) {
+        pointer last = m_data.begin() + count;
+
+        for (pointer iter = m_data.end(); iter != last; ++iter) {
+            ::new (static_cast<void*>(iter)) value_type;
+            m_data.set_end(iter + 1);
+        }
+    }
+
     // Shifts around data to be able to construct count elements into the
     // small_vector starting at pos. This function may reallocate so an iterator
     // to the position in which elements can be constructed is returned.
+    //
+    // The new capacity comes from the growth policy so repeated inserts are
+    // amortized, and the elements after pos are moved exactly once, either
+    // straight into their place in the new buffer or by a single shift.
     iterator make_space(const_iterator pos, size_type count) {
-        int index = static_cast<int>(pos - m_begin);
-        int new_size = size() + count;
-
-        if (new_size > capacity()) {
-            int new_cap = capacity() + count;
-            pointer new_begin = allocate(new_cap);
-
-            try {
-                uninitialized_relocate(m_begin, pos, new_begin);
-                uninitialized_relocate(pos, m_end, new_begin + index + count);
-            } catch (...) {
-                std::free(new_begin);
-                throw;
-            }
-
-            if (!is_small()) std::free(m_begin);
+        size_type index = static_cast<size_type>(pos - m_data.begin());
+        if (count > max_size() - size()) throw_length_error();
 
-            m_begin = new_begin;
-            m_end = new_begin + new_size;
-            m_end_cap = new_begin + new_cap;
+        if (size() + count > capacity()) {
+            grow_with_gap(index, count, use_base{});
         } else {
-            shift_data(pos, m_end, &m_begin[index] + count);
-            ++m_end;
+            detail::open_gap(m_data.begin() + index, m_data.end(),
+                             static_cast<std::size_t>(count));
+            m_data.set_end(m_data.end() + count);
         }
 
-        return &m_begin[index];
+        return &m_data.begin()[index];
     }
 
-    // Allocates a new chunk of memory based on the size_hint and returns a
-    // pointer to the beginning of the newly allocated chunk. The size of the
-    // newly allocated memory is put into the size_hint.
-    pointer allocate(int& size_hint) {
-        int next_pow = static_cast<int>(detail::next_power_of_two(capacity()));
-        size_hint = std::max(size_hint, next_pow);
+    // Moves the elements into a new buffer leaving count uninitialized
+    // elements at index.
+    void grow_with_gap(size_type index, size_type count, std::true_type) {
+        size_type new_size = size() + count;
+        size_type new_cap = next_capacity(new_size);
+
+        pointer new_begin =
+            static_cast<pointer>(detail::small_vector_base::grow_with_gap(
+                m_data.begin(), sizeof(value_type) * size(),
+                sizeof(value_type) * new_cap, sizeof(value_type) * index,
+                sizeof(value_type) * count, !is_small(), heap_alignment));
+        new_cap = usable_capacity(new_begin, new_cap, use_usable_size{});
 
-        return static_cast<pointer>(
-            detail::safe_malloc(sizeof(value_type) * size_hint));
+        m_data.reset(new_begin, new_size, new_cap);
     }
 
-    void grow(int size_hint) {
-        pointer new_begin = allocate(size_hint);
+    void grow_with_gap(size_type index, size_type count, std::false_type) {
+        size_type new_size = size() + count;
+
+        // Appending leaves no tail to move so the buffer may as well be
+        // extended in place.
+        if (index == size() && !is_small() && can_reallocate::value) {
+            grow(new_size);
+            m_data.set_end(m_data.end() + count);
+            return;
+        }
+
+        size_type new_cap = new_size;
+        pointer new_begin = allocate(new_cap);
 
         try {
-            uninitialized_relocate(m_begin, m_end, new_begin);
+            relocate_with_gap(new_begin, index, count);
         } catch (...) {
-            std::free(new_begin);
+            deallocate(new_begin, new_cap);
             throw;
         }
 
-        if (!is_small()) std::free(m_begin);
+        if (!is_small()) deallocate(m_data.begin(), capacity());
 
-        m_end_cap = new_begin + size_hint;
-        m_end = new_begin + size();
-        m_begin = new_begin;
+        m_data.reset(new_begin, new_size, new_cap);
     }
 
-    // Shift using std::memmove if T is trivially relocatable.
-    template <typename U = T>
-    typename std::enable_if<meta::is_trivially_relocatable<U>::value>::type
-    shift_data(const_iterator first, const_iterator last,
-               iterator dest) noexcept {
-        std::memmove(dest, first, sizeof(value_type) * (last - first));
+    // Relocates the elements into new_begin leaving count uninitialized
+    // elements at index. The elements are left untouched if a move
+    // constructor throws.
+    void relocate_with_gap(pointer new_begin, size_type index,
+                           size_type count) {
+        relocate_with_gap(
+            new_begin, index, count,
+            typename meta::is_nothrow_relocatable<T>::type{});
     }
 
-    // Shift by calling constructor and destructor as a pair.
-    template <typename U = T>
-    typename std::enable_if<!meta::is_trivially_relocatable<U>::value>::type
-    shift_data(const_iterator first, const_iterator last, iterator dest) {
-        if (dest < first) {
-            for (auto begin = first; begin != last; ++begin, (void)++dest) {
-                ::new (dest) value_type(std::move(*begin));
-                begin->~value_type();
-            }
-        } else {
-            for (const_reverse_iterator rbegin(last);
-                 rbegin != const_reverse_iterator(first);
-                 ++rbegin, (void)++dest) {
-                ::new (dest) value_type(std::move(*rbegin));
-                rbegin->~value_type();
-            }
+    void relocate_with_gap(pointer new_begin, size_type index,
+                           size_type count, std::true_type) noexcept {
+        pointer pos = m_data.begin() + index;
+        detail::uninitialized_relocate(m_data.begin(), pos, new_begin);
+        detail::uninitialized_relocate(pos, m_data.end(),
+                                       new_begin + index + count);
+    }
+
+    void relocate_with_gap(pointer new_begin, size_type index,
+                           size_type count, std::false_type) {
+        pointer pos = m_data.begin() + index;
+        detail::uninitialized_move(m_data.begin(), pos, new_begin);
+
+        try {
+            detail::uninitialized_move(pos, m_data.end(),
+                                       new_begin + index + count);
+        } catch (...) {
+            destroy_range(new_begin, new_begin + index);
+            throw;
         }
+
+        destroy_range(m_data.begin(), m_data.end());
     }
 
-    // Relocate using std::memcpy if T is trivially relocatable.
-    template <typename U = T>
-    typename std::enable_if<meta::is_trivially_relocatable<U>::value>::type
-    uninitialized_relocate(const_iterator first, const_iterator last,
-                           iterator dest) noexcept {
-        std::memcpy(dest, first, sizeof(value_type) * (last - first));
+    // Allocates a new chunk of memory based on the size_hint and returns a
+    // pointer to the beginning of the newly allocated chunk. The size of the
+    // newly allocated memory is put into the size_hint.
+    pointer allocate(size_type& size_hint) {
+        size_hint = next_capacity(size_hint);
+        pointer ptr = alloc_traits::allocate(this->allocator_ref(), size_hint);
+        size_hint = usable_capacity(ptr, size_hint, use_usable_size{});
+
+        return ptr;
     }
 
-    // Relocate by calling constructor and destructor as a pair since there is
-    // no risk of the constructor throwing.
-    template <typename U = T>
-    typename std::enable_if<!meta::is_trivially_relocatable<U>::value &&
-                            std::is_nothrow_move_constructible<U>::value>::type
-    uninitialized_relocate(const_iterator first, const_iterator last,
-                           iterator dest) noexcept {
-        for (auto begin = first; begin != last; ++begin, (void)++dest) {
-            ::new (dest) value_type(std::move(*begin));
-            begin->~value_type();
-        }
+    // The capacity returned by the growth policy is clamped to max_size() so
+    // that the byte size of the allocation can't overflow.
+    size_type next_capacity(size_type size_hint) const {
+        if (size_hint > max_size()) throw_length_error();
+
+        size_type next = GrowthPolicy::next_capacity(capacity(), size_hint);
+        return std::min(std::max(next, size_hint), max_size());
     }
 
-    // Relocate by calling the constructor and only after all elements have been
-    // relocated can the destructor for the old shells be called since the
-    // constructor might throw.
-    template <typename U = T>
-    typename std::enable_if<!meta::is_trivially_relocatable<U>::value &&
-                            !std::is_nothrow_move_constructible<U>::value>::type
-    uninitialized_relocate(const_iterator first, const_iterator last,
-                           iterator dest) {
-        for (auto begin = first; begin != last; ++begin, (void)++dest) {
-            ::new (dest) value_type(std::move(*begin));
+    [[noreturn]] CFDS_COLD static void throw_length_error() {
+        throw std::length_error("cfds::small_vector exceeded max_size()");
+    }
+
+    // Adopts the real size of the allocated block as the capacity when the
+    // growth policy asks for it.
+    size_type usable_capacity(pointer ptr, size_type count,
+                              std::true_type) const {
+        std::size_t usable = this->allocator_ref().usable_size(ptr, count);
+        std::size_t max = static_cast<std::size_t>(max_size());
+        return static_cast<size_type>(std::min(usable, max));
+    }
+
+    size_type usable_capacity(pointer, size_type count,
+                              std::false_type) const {
+        return count;
+    }
+
+    // Resizes the heap buffer through the allocator which may extend the
+    // block in place instead of copying the elements. Returns false when the
+    // elements have to be relocated into a new buffer instead.
+    bool reallocate(size_type new_cap, std::true_type) {
+        size_type count = size();
+        pointer new_begin =
+            this->allocator_ref().reallocate(m_data.begin(), capacity(),
+                                             new_cap);
+        new_cap = usable_capacity(new_begin, new_cap, use_usable_size{});
+
+        m_data.reset(new_begin, count, new_cap);
+
+        return true;
+    }
+
+    bool reallocate(size_type, std::false_type) { return false; }
+
+    // Grows the capacity to fit count more elements, size() + count is never
+    // computed when it would exceed max_size() since it could overflow.
+    CFDS_NOINLINE void grow_by(size_type count) {
+        if (count > max_size() - size()) throw_length_error();
+        grow(size() + count);
+    }
+
+    CFDS_NOINLINE void grow(size_type size_hint) {
+        grow(size_hint, use_base{});
+    }
+
+    void grow(size_type size_hint, std::true_type) {
+        size_type new_cap = next_capacity(size_hint);
+
+        pointer new_begin =
+            static_cast<pointer>(detail::small_vector_base::grow(
+                m_data.begin(), sizeof(value_type) * size(),
+                sizeof(value_type) * new_cap, !is_small(), heap_alignment));
+        new_cap = usable_capacity(new_begin, new_cap, use_usable_size{});
+
+        m_data.reset(new_begin, size(), new_cap);
+    }
+
+    void grow(size_type size_hint, std::false_type) {
+        if (!is_small()) {
+            size_type new_cap = next_capacity(size_hint);
+            if (reallocate(new_cap, can_reallocate{})) return;
         }
 
-        for (auto begin = first; begin != last; ++begin) {
-            begin->~value_type();
+        pointer new_begin = allocate(size_hint);
+
+        try {
+            detail::uninitialized_relocate(m_data.begin(), m_data.end(),
+                                           new_begin);
+        } catch (...) {
+            deallocate(new_begin, size_hint);
+            throw;
         }
+
+        if (!is_small()) deallocate(m_data.begin(), capacity());
+
+        m_data.reset(new_begin, size(), size_hint);
     }
 };
 
-template <typename T, int N = 4>
-class small_vector : public small_vector_header<T>,
-                     private detail::aligned_storage_base<T, N> {
+template <typename T, typename Allocator, typename GrowthPolicy,
+          typename Layout>
+constexpr std::size_t
+    small_vector_header<T, Allocator, GrowthPolicy, Layout>::alignment;
+
+template <typename T, typename Allocator, typename GrowthPolicy,
+          typename Layout>
+constexpr std::size_t
+    small_vector_header<T, Allocator, GrowthPolicy, Layout>::heap_alignment;
+
+template <typename T, int N = 4, typename Allocator = malloc_allocator<T>,
+          typename GrowthPolicy = power_of_two_growth,
+          typename Layout = pointer_layout>
+class small_vector
+    : public small_vector_header<T, Allocator, GrowthPolicy, Layout>,
+      private detail::aligned_storage_base<
+          T, N,
+          small_vector_header<T, Allocator, GrowthPolicy, Layout>::alignment> {
     static_assert(N >= 0,
                   "small_vector<T, N> requires N to be greater or equal to 0.");
 
+    using header_type = small_vector_header<T, Allocator, GrowthPolicy, Layout>;
+    using alloc_traits = std::allocator_traits<Allocator>;
+
  public:
-    small_vector() noexcept : small_vector_header<T>(N) {}
+    small_vector() noexcept : header_type(N) {}
+
+    explicit small_vector(const Allocator& alloc) noexcept
+        : header_type(N, alloc) {}
 
     ~small_vector() { this->destroy_range(this->begin(), this->end()); }
 
+    // Moves the elements back into the inline buffer when they fit.
+    void shrink_to_fit() { this->shrink_to(this->size(), N); }
+
+    using header_type::swap;
+
+    // Both vectors have an inline capacity of N which lets a heap buffer be
+    // handed over to a vector whose elements are stored inline.
+    void swap(small_vector& other) { this->swap_impl(other, N, N); }
+
     template <typename InputIterator>
     small_vector(typename std::enable_if<
                      meta::is_input_iterator<InputIterator>::value &&
                          !meta::is_forward_iterator<InputIterator>::value,
                      InputIterator>::type first,
-                 InputIterator last)
-        : small_vector() {
+                 InputIterator last, const Allocator& alloc = Allocator())
+        : small_vector(alloc) {
         for (; first != last; ++first) {
             this->emplace_back(*first);
         }
@@ -640,81 +1144,235 @@ class small_vector : public small_vector_header<T>,
     small_vector(typename std::enable_if<
                      meta::is_forward_iterator<ForwardIterator>::value,
                      ForwardIterator>::type first,
-                 ForwardIterator last)
-        : small_vector() {
-        this->reserve(std::distance(first, last));
+                 ForwardIterator last, const Allocator& alloc = Allocator())
+        : small_vector(alloc) {
+        this->assign(first, last);
+    }
 
-        for (; first != last; ++first) {
-            this->emplace_back(*first);
-        }
+    small_vector(std::initializer_list<T> ilist,
+                 const Allocator& alloc = Allocator())
+        : small_vector(alloc) {
+        this->assign(ilist.begin(), ilist.end());
     }
 
-    small_vector(std::initializer_list<T> ilist) : small_vector() {
-        this->reserve(ilist.size());
+    small_vector(const small_vector& other)
+        : small_vector(static_cast<const header_type&>(other)) {}
 
-        for (auto&& element : ilist) {
-            this->emplace_back(element);
-        }
+    small_vector(const header_type& other)
+        : small_vector(other,
+                       alloc_traits::select_on_container_copy_construction(
+                           other.get_allocator())) {}
+
+    small_vector(const header_type& other, const Allocator& alloc)
+        : small_vector(alloc) {
+        if (!other.empty()) header_type::operator=(other);
+    }
+
+    // Never allocates since the heap buffer of other is stolen and inline
+    // elements fit in the inline buffer, which lets std::vector move rather
+    // than copy small vectors when it grows.
+    small_vector(small_vector&& other) noexcept(
+        std::is_nothrow_move_constructible<T>::value)
+        : small_vector(static_cast<header_type&&>(other)) {}
+
+    small_vector(header_type&& other) : small_vector(other.get_allocator()) {
+        if (!other.empty()) header_type::operator=(std::move(other));
+    }
+
+    small_vector& operator=(const small_vector& other) {
+        header_type::operator=(other);
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) {
+        header_type::operator=(std::move(other));
+        return *this;
+    }
+
+    small_vector& operator=(const header_type& other) {
+        header_type::operator=(other);
+        return *this;
+    }
+
+    small_vector& operator=(header_type&& other) {
+        header_type::operator=(std::move(other));
+        return *this;
+    }
+};
+
+namespace meta {
+
+// small_vector relocates by copying its bytes as long as the elements and
+// the allocator can be relocated without throwing, see
+// small_vector_header::relocate.
+template <typename T, int N, typename Allocator, typename GrowthPolicy,
+          typename Layout>
+struct relocate_traits<
+    small_vector<T, N, Allocator, GrowthPolicy, Layout>,
+    typename std::enable_if<
+        is_nothrow_relocatable<T>::value &&
+        is_trivially_relocatable<Allocator>::value>::type> : std::true_type {
+    using vector_type = small_vector<T, N, Allocator, GrowthPolicy, Layout>;
+    using header_type = small_vector_header<T, Allocator, GrowthPolicy, Layout>;
+
+    static void relocate(vector_type* src, vector_type* dest) noexcept {
+        header_type::relocate(src, dest);
+    }
+};
+
+} // namespace meta
+
+// Vector whose small buffer is storage provided by the caller with a capacity
+// decided at runtime, e.g. a stack array or a block from an arena, instead of
+// an inline buffer of N elements. It spills to Allocator like
+// small_vector<T, N> once the buffer is full and never frees the buffer which
+// has to outlive the vector.
+template <typename T, typename Allocator = malloc_allocator<T>,
+          typename GrowthPolicy = power_of_two_growth,
+          typename Layout = pointer_layout>
+class external_small_vector
+    : public small_vector_header<T, Allocator, GrowthPolicy,
+                                 external_buffer_layout<Layout>> {
+    using header_type = small_vector_header<T, Allocator, GrowthPolicy,
+                                            external_buffer_layout<Layout>>;
+
+ public:
+    using size_type = typename header_type::size_type;
+
+    // buffer has to be aligned to alignment and hold capacity elements.
+    external_small_vector(void* buffer, size_type capacity,
+                          const Allocator& alloc = Allocator()) noexcept
+        : header_type(static_cast<T*>(buffer), capacity, alloc) {}
+
+    external_small_vector(const external_small_vector&) = delete;
+
+    ~external_small_vector() {
+        this->destroy_range(this->begin(), this->end());
     }
 
-    small_vector(const small_vector_header<T>& other) : small_vector() {
-        if (!other.empty()) small_vector_header<T>::operator=(other);
+    external_small_vector& operator=(const external_small_vector& other) {
+        header_type::operator=(other);
+        return *this;
     }
 
-    small_vector(small_vector_header<T>&& other) : small_vector() {
-        if (!other.empty()) small_vector_header<T>::operator=(std::move(other));
+    external_small_vector& operator=(external_small_vector&& other) {
+        header_type::operator=(std::move(other));
+        return *this;
     }
 
-    small_vector& operator=(const small_vector_header<T>& other) {
-        small_vector_header<T>::operator=(other);
+    external_small_vector& operator=(const header_type& other) {
+        header_type::operator=(other);
         return *this;
     }
 
-    small_vector& operator=(small_vector_header<T>&& other) {
-        small_vector_header<T>::operator=(std::move(other));
+    external_small_vector& operator=(header_type&& other) {
+        header_type::operator=(std::move(other));
         return *this;
     }
 };
 
 template <typename T>
-bool operator==(const small_vector_header<T>& x,
-                const small_vector_header<T>& y) {
+using external_small_vector_header =
+    small_vector_header<T, malloc_allocator<T>, power_of_two_growth,
+                        external_buffer_layout<pointer_layout>>;
+
+// small_vector with a 16 byte header, see compact_layout.
+template <typename T, int N = 4>
+using compact_small_vector = small_vector<T, N, malloc_allocator<T>,
+                                          power_of_two_growth, compact_layout>;
+
+// small_vector with std::size_t as size_type, see large_layout.
+template <typename T, int N = 4>
+using large_small_vector = small_vector<T, N, malloc_allocator<T>,
+                                        power_of_two_growth, large_layout>;
+
+// small_vector which spills into an arena, e.g. arena_small_vector<int> v(a)
+// where a is a cfds::arena. Spilling is a pointer bump and destroying the
+// vector never frees memory. It binds to arena_small_vector_header<T>& rather
+// than small_vector_header<T>&, see arena.hpp.
+template <typename T>
+using arena_small_vector_header =
+    small_vector_header<T, arena_allocator<T>>;
+
+template <typename T, int N = 4>
+using arena_small_vector = small_vector<T, N, arena_allocator<T>>;
+
+// small_vector which reuses spilled buffers through a thread local cache and
+// adopts the whole size class as capacity, see thread_cache.hpp.
+template <typename T, int N = 4>
+using cached_small_vector =
+    small_vector<T, N, cached_allocator<T>, size_class_growth<>>;
+
+// small_vector whose data() is aligned to Alignment bytes wherever the
+// elements live, e.g. for SIMD code using aligned loads.
+template <typename T, std::size_t Alignment = 64>
+using aligned_small_vector_header =
+    small_vector_header<T, aligned_allocator<T, Alignment>>;
+
+template <typename T, int N = 4, std::size_t Alignment = 64>
+using aligned_small_vector =
+    small_vector<T, N, aligned_allocator<T, Alignment>>;
+
+template <typename T, typename... Options>
+bool operator==(const small_vector_header<T, Options...>& x,
+                const small_vector_header<T, Options...>& y) {
     return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
 }
 
-template <typename T>
-bool operator!=(const small_vector_header<T>& x,
-                const small_vector_header<T>& y) {
+template <typename T, typename... Options>
+bool operator!=(const small_vector_header<T, Options...>& x,
+                const small_vector_header<T, Options...>& y) {
     return !(x == y);
 }
 
-template <typename T>
-bool operator<(const small_vector_header<T>& x,
-               const small_vector_header<T>& y) {
+template <typename T, typename... Options>
+bool operator<(const small_vector_header<T, Options...>& x,
+               const small_vector_header<T, Options...>& y) {
     return std::lexicographical_compare(x.begin(), x.end(), y.begin(), y.end());
 }
 
-template <typename T>
-bool operator>(const small_vector_header<T>& x,
-               const small_vector_header<T>& y) {
+template <typename T, typename... Options>
+bool operator>(const small_vector_header<T, Options...>& x,
+               const small_vector_header<T, Options...>& y) {
     return y < x;
 }
 
-template <typename T>
-bool operator>=(const small_vector_header<T>& x,
-                const small_vector_header<T>& y) {
+template <typename T, typename... Options>
+bool operator>=(const small_vector_header<T, Options...>& x,
+                const small_vector_header<T, Options...>& y) {
     return !(x < y);
 }
 
-template <typename T>
-bool operator<=(const small_vector_header<T>& x,
-                const small_vector_header<T>& y) {
+template <typename T, typename... Options>
+bool operator<=(const small_vector_header<T, Options...>& x,
+                const small_vector_header<T, Options...>& y) {
     return !(y < x);
 }
 
-template <typename T>
-void swap(small_vector_header<T>& x, small_vector_header<T>& y) {
+template <typename T, typename... Options>
+void swap(small_vector_header<T, Options...>& x,
+          small_vector_header<T, Options...>& y) {
     x.swap(y);
 }
 
+template <typename T, int N, typename... Options>
+void swap(small_vector<T, N, Options...>& x,
+          small_vector<T, N, Options...>& y) {
+    x.swap(y);
+}
+
+#if CFDS_HAS_PMR
+namespace pmr {
+
+template <typename T>
+using small_vector_header =
+    cfds::small_vector_header<T, std::pmr::polymorphic_allocator<T>>;
+
+template <typename T, int N = 4>
+using small_vector =
+    cfds::small_vector<T, N, std::pmr::polymorphic_allocator<T>>;
+
+} // namespace pmr
+#endif
+
 } // namespace cfds
@@ -0,0 +1,460 @@
+// Contains the definition of static_vector<T, N> which stores up to N elements
+// inline and never allocates. Since the elements never move to the heap
+// there is no pointer to them, only the inline buffer followed by the size
+// stored in the smallest unsigned type which can hold N.
+//
+// Operations which would exceed the capacity throw std::length_error without
+// touching the vector, while try_emplace_back() and try_push_back() report
+// it by returning nullptr for callers which can't throw. The element
+// operations are shared with small_vector, see detail/bulk.hpp.
+
+#pragma once
+
+#include "meta.hpp"
+
+#include "detail/bulk.hpp"
+#include "detail/small_vector_base.hpp"
+#include "detail/utility.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace cfds {
+namespace detail {
+
+// The smallest unsigned integer type which can hold N.
+template <std::uintmax_t N>
+using static_size_type = typename std::conditional<
+    N <= UINT8_MAX, std::uint8_t,
+    typename std::conditional<
+        N <= UINT16_MAX, std::uint16_t,
+        typename std::conditional<N <= UINT32_MAX, std::uint32_t,
+                                  std::uint64_t>::type>::type>::type;
+
+} // namespace detail
+
+template <typename T, int N>
+class static_vector : private detail::aligned_storage_base<T, N> {
+    static_assert(N >= 0, "static_vector<T, N> requires N to be greater or "
+                          "equal to 0.");
+
+    // The inline buffer is a base class so that it takes up no space when N
+    // is 0.
+    using storage_type = detail::aligned_storage_base<T, N>;
+
+ public:
+    using value_type = T;
+    using size_type = int;
+    using difference_type = std::ptrdiff_t;
+
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    // The elements are stored in place so the vector relocates like them.
+    using is_trivially_relocatable = meta::is_trivially_relocatable<T>;
+
+    static_vector() noexcept : m_size(0) {}
+
+    explicit static_vector(size_type count) : static_vector() {
+        resize(count);
+    }
+
+    static_vector(size_type count, const value_type& value)
+        : static_vector() {
+        assign(count, value);
+    }
+
+    template <typename InputIterator,
+              typename = typename std::enable_if<
+                  meta::is_input_iterator<InputIterator>::value>::type>
+    static_vector(InputIterator first, InputIterator last) : static_vector() {
+        assign(first, last);
+    }
+
+    static_vector(std::initializer_list<T> ilist) : static_vector() {
+        assign(ilist.begin(), ilist.end());
+    }
+
+    static_vector(const static_vector& other) : static_vector() {
+        set_size(static_cast<size_type>(
+            detail::uninitialized_copy_n(other.begin(), other.size(), data()) -
+            data()));
+    }
+
+    // Moves the elements one by one, other keeps its moved from elements.
+    static_vector(static_vector&& other) noexcept(
+        std::is_nothrow_move_constructible<T>::value)
+        : static_vector() {
+        detail::uninitialized_move(other.begin(), other.end(), data());
+        set_size(other.size());
+    }
+
+    ~static_vector() { detail::destroy_range(begin(), end()); }
+
+    static_vector& operator=(const static_vector& other) {
+        if (this != &other) assign(other.begin(), other.end());
+        return *this;
+    }
+
+    static_vector& operator=(static_vector&& other) noexcept(
+        std::is_nothrow_move_constructible<T>::value &&
+        std::is_nothrow_move_assignable<T>::value) {
+        if (this == &other) return *this;
+
+        size_type shared = std::min(size(), other.size());
+        std::move(other.begin(), other.begin() + shared, begin());
+        erase_to_end(begin() + shared);
+        detail::uninitialized_move(other.begin() + shared, other.end(), end());
+        set_size(other.size());
+
+        return *this;
+    }
+
+    static_vector& operator=(std::initializer_list<T> ilist) {
+        assign(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    iterator begin() noexcept { return data(); }
+    const_iterator begin() const noexcept { return data(); }
+    const_iterator cbegin() const noexcept { return data(); }
+
+    iterator end() noexcept { return data() + m_size; }
+    const_iterator end() const noexcept { return data() + m_size; }
+    const_iterator cend() const noexcept { return end(); }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+    size_type size() const noexcept { return static_cast<size_type>(m_size); }
+    bool empty() const noexcept { return m_size == 0; }
+    bool full() const noexcept { return m_size == N; }
+
+    static constexpr size_type capacity() noexcept { return N; }
+    static constexpr size_type max_size() noexcept { return N; }
+
+    pointer data() noexcept {
+        return reinterpret_cast<pointer>(static_cast<storage_type*>(this));
+    }
+
+    const_pointer data() const noexcept {
+        return reinterpret_cast<const_pointer>(
+            static_cast<const storage_type*>(this));
+    }
+
+    reference operator[](size_type index) { return data()[index]; }
+    const_reference operator[](size_type index) const {
+        return data()[index];
+    }
+
+    reference at(size_type index) {
+        if (index < 0 || index >= size()) throw std::out_of_range("");
+        return data()[index];
+    }
+
+    const_reference at(size_type index) const {
+        if (index < 0 || index >= size()) throw std::out_of_range("");
+        return data()[index];
+    }
+
+    reference front() { return data()[0]; }
+    const_reference front() const { return data()[0]; }
+
+    reference back() { return data()[m_size - 1]; }
+    const_reference back() const { return data()[m_size - 1]; }
+
+    void assign(size_type count, const value_type& value) {
+        check_size(count);
+        clear();
+        detail::uninitialized_fill_n(data(), count, value);
+        set_size(count);
+    }
+
+    template <typename InputIterator>
+    typename std::enable_if<
+        meta::is_input_iterator<InputIterator>::value &&
+        !meta::is_forward_iterator<InputIterator>::value>::type
+    assign(InputIterator first, InputIterator last) {
+        clear();
+
+        for (; first != last; ++first) {
+            emplace_back(*first);
+        }
+    }
+
+    template <typename ForwardIterator>
+    typename std::enable_if<
+        meta::is_forward_iterator<ForwardIterator>::value>::type
+    assign(ForwardIterator first, ForwardIterator last) {
+        auto count = static_cast<size_type>(std::distance(first, last));
+        check_size(count);
+
+        clear();
+        set_size(static_cast<size_type>(
+            detail::uninitialized_copy_n(first, count, data()) - data()));
+    }
+
+    void assign(std::initializer_list<T> ilist) {
+        assign(ilist.begin(), ilist.end());
+    }
+
+    template <typename... Args>
+    reference emplace_back(Args&&... args) {
+        if (CFDS_UNLIKELY(full())) throw_length_error();
+        return unchecked_emplace_back(std::forward<Args>(args)...);
+    }
+
+    void push_back(const value_type& value) { emplace_back(value); }
+    void push_back(value_type&& value) { emplace_back(std::move(value)); }
+
+    // Returns a pointer to the new element, or nullptr without constructing
+    // anything when the vector is full.
+    template <typename... Args>
+    pointer try_emplace_back(Args&&... args) {
+        if (CFDS_UNLIKELY(full())) return nullptr;
+        return &unchecked_emplace_back(std::forward<Args>(args)...);
+    }
+
+    pointer try_push_back(const value_type& value) {
+        return try_emplace_back(value);
+    }
+
+    pointer try_push_back(value_type&& value) {
+        return try_emplace_back(std::move(value));
+    }
+
+    // Requires the vector not to be full.
+    template <typename... Args>
+    reference unchecked_emplace_back(Args&&... args) {
+        ::new (static_cast<void*>(end()))
+            value_type(std::forward<Args>(args)...);
+        ++m_size;
+        return back();
+    }
+
+    void pop_back() {
+        --m_size;
+        end()->~value_type();
+    }
+
+    void resize(size_type count) {
+        check_size(count);
+
+        if (count < size()) {
+            erase_to_end(begin() + count);
+            return;
+        }
+
+        for (pointer iter = end(); iter != begin() + count; ++iter) {
+            ::new (static_cast<void*>(iter)) value_type();
+            ++m_size;
+        }
+    }
+
+    void resize(size_type count, const value_type& value) {
+        check_size(count);
+
+        if (count < size()) {
+            erase_to_end(begin() + count);
+            return;
+        }
+
+        detail::uninitialized_fill_n(end(), count - size(), value);
+        set_size(count);
+    }
+
+    void clear() noexcept { erase_to_end(begin()); }
+
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        iterator iter = make_space(pos, 1);
+        ::new (static_cast<void*>(iter))
+            value_type(std::forward<Args>(args)...);
+        return iter;
+    }
+
+    iterator insert(const_iterator pos, const value_type& value) {
+        if (CFDS_UNLIKELY(full())) throw_length_error();
+
+        // value may be an element of this vector which is shifted.
+        value_type copy(value);
+        return emplace(pos, std::move(copy));
+    }
+
+    iterator insert(const_iterator pos, value_type&& value) {
+        return emplace(pos, std::move(value));
+    }
+
+    iterator insert(const_iterator pos, size_type count,
+                    const value_type& value) {
+        if (count > capacity() - size()) throw_length_error();
+
+        value_type copy(value);
+        iterator iter = make_space(pos, count);
+        detail::uninitialized_fill_n(iter, static_cast<std::size_t>(count),
+                                     copy);
+
+        return iter;
+    }
+
+    // Input iterators are single pass so the elements are appended and
+    // rotated into place, the vector is left unchanged if they don't fit.
+    template <typename InputIterator>
+    typename std::enable_if<
+        meta::is_input_iterator<InputIterator>::value &&
+            !meta::is_forward_iterator<InputIterator>::value,
+        iterator>::type
+    insert(const_iterator pos, InputIterator first, InputIterator last) {
+        size_type index = static_cast<size_type>(pos - begin());
+        size_type old_size = size();
+
+        try {
+            for (; first != last; ++first) {
+                emplace_back(*first);
+            }
+        } catch (...) {
+            erase_to_end(begin() + old_size);
+            throw;
+        }
+
+        std::rotate(begin() + index, begin() + old_size, end());
+
+        return begin() + index;
+    }
+
+    template <typename ForwardIterator>
+    typename std::enable_if<meta::is_forward_iterator<ForwardIterator>::value,
+                            iterator>::type
+    insert(const_iterator pos, ForwardIterator first, ForwardIterator last) {
+        auto count = static_cast<size_type>(std::distance(first, last));
+        iterator iter = make_space(pos, count);
+        detail::uninitialized_copy_n(first, count, iter);
+
+        return iter;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<T> ilist) {
+        return insert(pos, ilist.begin(), ilist.end());
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        iterator iter = begin() + (first - begin());
+        if (first == last) return iter;
+
+        detail::destroy_range(first, last);
+        detail::shift_data(last, const_cast<const_pointer>(end()), iter);
+        m_size = static_cast<stored_size_type>(m_size - (last - first));
+
+        return iter;
+    }
+
+    // The shared elements are exchanged bytewise when T is trivially
+    // relocatable, and the rest are relocated into the shorter vector.
+    void swap(static_vector& other) {
+        static_vector& big = size() >= other.size() ? *this : other;
+        static_vector& small = size() >= other.size() ? other : *this;
+        size_type shared = small.size();
+
+        swap_elements(big.data(), small.data(), shared,
+                      typename meta::is_trivially_relocatable<T>::type{});
+
+        detail::uninitialized_relocate(big.data() + shared, big.end(),
+                                       small.data() + shared);
+
+        small.set_size(big.size());
+        big.set_size(shared);
+    }
+
+    friend bool operator==(const static_vector& x, const static_vector& y) {
+        return x.size() == y.size() &&
+               std::equal(x.begin(), x.end(), y.begin());
+    }
+
+    friend bool operator!=(const static_vector& x, const static_vector& y) {
+        return !(x == y);
+    }
+
+    friend bool operator<(const static_vector& x, const static_vector& y) {
+        return std::lexicographical_compare(x.begin(), x.end(), y.begin(),
+                                            y.end());
+    }
+
+ private:
+    using stored_size_type = detail::static_size_type<N>;
+
+    stored_size_type m_size;
+
+    void set_size(size_type count) noexcept {
+        m_size = static_cast<stored_size_type>(count);
+    }
+
+    void erase_to_end(pointer pos) noexcept {
+        detail::destroy_range(pos, end());
+        set_size(static_cast<size_type>(pos - begin()));
+    }
+
+    // Opens a gap of count uninitialized elements at pos and returns it.
+    iterator make_space(const_iterator pos, size_type count) {
+        if (count > capacity() - size()) throw_length_error();
+
+        iterator iter = begin() + (pos - begin());
+        detail::open_gap(iter, end(), static_cast<std::size_t>(count));
+        m_size = static_cast<stored_size_type>(m_size + count);
+
+        return iter;
+    }
+
+    static void check_size(size_type count) {
+        if (count > capacity()) throw_length_error();
+    }
+
+    static void swap_elements(pointer first, pointer second, size_type count,
+                              std::true_type) noexcept {
+        detail::small_vector_base::swap(first, second,
+                                        sizeof(value_type) * count);
+    }
+
+    static void swap_elements(pointer first, pointer second, size_type count,
+                              std::false_type) {
+        for (size_type i = 0; i < count; ++i) {
+            using std::swap;
+            swap(first[i], second[i]);
+        }
+    }
+
+    [[noreturn]] CFDS_COLD static void throw_length_error() {
+        throw std::length_error("cfds::static_vector exceeded capacity()");
+    }
+};
+
+template <typename T, int N>
+void swap(static_vector<T, N>& x, static_vector<T, N>& y) {
+    x.swap(y);
+}
+
+} // namespace cfds
@@ -0,0 +1,208 @@
+// Contains the definition of cached_allocator<T> which keeps freed blocks in a
+// thread local cache instead of returning them to malloc, so that containers
+// which repeatedly spill and die reuse the same few blocks without going
+// through malloc and free.
+//
+// Blocks are rounded up to power of two size classes between 16 bytes and
+// detail::thread_cache_max_block bytes, larger blocks bypass the cache. Every
+// size class holds at most detail::thread_cache_class_bytes bytes per thread
+// which bounds the footprint of a thread to about 1.6 MiB. A block may be
+// freed by another thread than the one allocating it, it then ends up in the
+// cache of the freeing thread. flush_thread_cache() returns the blocks cached
+// by the calling thread to malloc, which also happens when the thread exits.
+
+#pragma once
+
+#include "detail/utility.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace cfds {
+namespace detail {
+
+constexpr std::size_t thread_cache_min_block = 16;
+constexpr std::size_t thread_cache_max_block = std::size_t(1) << 16;
+constexpr std::size_t thread_cache_class_bytes = std::size_t(1) << 17;
+constexpr int thread_cache_classes = 13;
+
+// Trivially destructible so that it stays usable while other thread local
+// objects are destroyed, thread_cache_guard flushes it on thread exit.
+struct thread_cache_state {
+    void* free_lists[thread_cache_classes];
+    std::size_t cached_bytes[thread_cache_classes];
+    bool registered;
+    bool destroyed;
+};
+
+inline thread_cache_state& thread_cache() {
+    static thread_local thread_cache_state state;
+    return state;
+}
+
+// Returns the index of the smallest size class holding bytes.
+inline int thread_cache_class(std::size_t bytes) noexcept {
+    int index = 0;
+    std::size_t size = thread_cache_min_block;
+
+    while (size < bytes) {
+        size *= 2;
+        ++index;
+    }
+
+    return index;
+}
+
+inline std::size_t thread_cache_class_size(int index) noexcept {
+    return thread_cache_min_block << index;
+}
+
+inline void flush_thread_cache(thread_cache_state& state) noexcept {
+    for (int i = 0; i < thread_cache_classes; ++i) {
+        void* block = state.free_lists[i];
+
+        while (block != nullptr) {
+            void* next = *static_cast<void**>(block);
+            std::free(block);
+            block = next;
+        }
+
+        state.free_lists[i] = nullptr;
+        state.cached_bytes[i] = 0;
+    }
+}
+
+struct thread_cache_guard {
+    ~thread_cache_guard() {
+        thread_cache_state& state = thread_cache();
+        flush_thread_cache(state);
+        state.destroyed = true;
+    }
+};
+
+inline void register_thread_cache(thread_cache_state& state) noexcept {
+    static thread_local thread_cache_guard guard;
+    static_cast<void>(guard);
+    state.registered = true;
+}
+
+inline void* thread_cache_allocate(std::size_t bytes) {
+    if (bytes > thread_cache_max_block) return safe_malloc(bytes);
+
+    int index = thread_cache_class(bytes);
+    thread_cache_state& state = thread_cache();
+    void* block = state.free_lists[index];
+
+    if (block == nullptr) {
+        return safe_malloc(thread_cache_class_size(index));
+    }
+
+    state.free_lists[index] = *static_cast<void**>(block);
+    state.cached_bytes[index] -= thread_cache_class_size(index);
+
+    return block;
+}
+
+inline void thread_cache_deallocate(void* block, std::size_t bytes) noexcept {
+    if (bytes > thread_cache_max_block) {
+        std::free(block);
+        return;
+    }
+
+    int index = thread_cache_class(bytes);
+    std::size_t size = thread_cache_class_size(index);
+    thread_cache_state& state = thread_cache();
+
+    if (state.destroyed ||
+        state.cached_bytes[index] + size > thread_cache_class_bytes) {
+        std::free(block);
+        return;
+    }
+
+    if (!state.registered) register_thread_cache(state);
+
+    *static_cast<void**>(block) = state.free_lists[index];
+    state.free_lists[index] = block;
+    state.cached_bytes[index] += size;
+}
+
+} // namespace detail
+
+// Returns the blocks cached by the calling thread to malloc.
+inline void flush_thread_cache() noexcept {
+    detail::flush_thread_cache(detail::thread_cache());
+}
+
+// Returns the number of bytes cached by the calling thread.
+inline std::size_t thread_cache_bytes() noexcept {
+    const detail::thread_cache_state& state = detail::thread_cache();
+    std::size_t bytes = 0;
+
+    for (int i = 0; i < detail::thread_cache_classes; ++i) {
+        bytes += state.cached_bytes[i];
+    }
+
+    return bytes;
+}
+
+// Stateless allocator which obtains its blocks through the thread local
+// cache. It reports the full size class as usable so that it can be combined
+// with size_class_growth<Policy> to use the whole block.
+template <typename T>
+struct cached_allocator {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "cached_allocator<T> requires T to not be over-aligned.");
+
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = cached_allocator<U>;
+    };
+
+    cached_allocator() noexcept = default;
+
+    template <typename U>
+    cached_allocator(const cached_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t count) {
+        if (count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+
+        return static_cast<T*>(
+            detail::thread_cache_allocate(sizeof(T) * count));
+    }
+
+    void deallocate(T* ptr, std::size_t count) noexcept {
+        detail::thread_cache_deallocate(ptr, sizeof(T) * count);
+    }
+
+    std::size_t usable_size(T*, std::size_t count) const noexcept {
+        std::size_t bytes = sizeof(T) * count;
+        if (bytes > detail::thread_cache_max_block) return count;
+
+        int index = detail::thread_cache_class(bytes);
+        return detail::thread_cache_class_size(index) / sizeof(T);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const cached_allocator<T>&,
+                const cached_allocator<U>&) noexcept {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const cached_allocator<T>&,
+                const cached_allocator<U>&) noexcept {
+    return false;
+}
+
+} // namespace cfds
@@ -0,0 +1,140 @@
+#include <cfds/small_vector.hpp>
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace {
+
+struct alignas(64) block {
+    float values[4];
+    int id;
+};
+
+struct alignas(32) tagged {
+    std::string name;
+};
+
+template <typename T>
+bool is_aligned(const T* ptr, std::size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+} // namespace
+
+TEST_CASE("small_vector of over-aligned elements", "[aligned]") {
+    SECTION("inline buffer") {
+        cfds::small_vector<block, 2> v;
+        v.push_back(block{{1, 2, 3, 4}, 1});
+        v.push_back(block{{5, 6, 7, 8}, 2});
+
+        CHECK(v.is_small());
+        CHECK(is_aligned(v.data(), 64));
+        CHECK(reinterpret_cast<char*>(v.data()) >
+              reinterpret_cast<char*>(&v));
+        CHECK(reinterpret_cast<char*>(v.data() + 2) <=
+              reinterpret_cast<char*>(&v) + sizeof(v));
+        CHECK(v[1].id == 2);
+    }
+
+    SECTION("heap buffer") {
+        cfds::small_vector<block, 2> v;
+
+        for (int i = 0; i < 20; ++i) {
+            v.push_back(block{{0, 0, 0, 0}, i});
+            CHECK(is_aligned(v.data(), 64));
+        }
+
+        CHECK(!v.is_small());
+        CHECK(v[19].id == 19);
+
+        v.resize(2);
+        v.shrink_to_fit();
+        CHECK(v.is_small());
+        CHECK(is_aligned(v.data(), 64));
+        CHECK(v[1].id == 1);
+    }
+
+    SECTION("not trivially relocatable") {
+        cfds::small_vector<tagged, 1> v;
+
+        for (int i = 0; i < 10; ++i) {
+            v.push_back(tagged{std::to_string(i)});
+            CHECK(is_aligned(v.data(), 32));
+        }
+
+        cfds::small_vector<tagged, 1> w(std::move(v));
+        CHECK(is_aligned(w.data(), 32));
+        CHECK(w[9].name == "9");
+    }
+}
+
+TEST_CASE("aligned_small_vector aligns data", "[aligned]") {
+    using vector = cfds::aligned_small_vector<float, 8>;
+
+    static_assert(vector::alignment == 64, "");
+    static_assert(alignof(vector) == 64, "");
+    static_assert(cfds::aligned_small_vector<float, 8, 32>::alignment == 32,
+                  "");
+    static_assert(cfds::small_vector<double>::alignment == alignof(double),
+                  "");
+
+    vector v;
+    CHECK(is_aligned(v.data(), 64));
+
+    for (int i = 0; i < 1000; ++i) {
+        v.push_back(static_cast<float>(i));
+        CHECK(is_aligned(v.data(), 64));
+    }
+
+    CHECK(v[999] == 999.0f);
+
+    SECTION("copies and moves") {
+        vector copy(v);
+        CHECK(is_aligned(copy.data(), 64));
+        CHECK(copy == v);
+
+        vector moved(std::move(copy));
+        CHECK(is_aligned(moved.data(), 64));
+
+        cfds::aligned_small_vector_header<float>& header = moved;
+        header.resize(4);
+        header.shrink_to_fit();
+        CHECK(is_aligned(header.data(), 64));
+    }
+
+    SECTION("spilling from a misaligned size") {
+        cfds::aligned_small_vector<char, 3> bytes;
+
+        for (int i = 0; i < 100; ++i) {
+            bytes.push_back(static_cast<char>(i));
+            CHECK(is_aligned(bytes.data(), 64));
+        }
+
+        CHECK(bytes[99] == 99);
+    }
+}
+
+TEST_CASE("aligned_allocator returns aligned blocks", "[aligned]") {
+    cfds::aligned_allocator<int, 128> alloc;
+
+    int* ptr = alloc.allocate(10);
+    CHECK(is_aligned(ptr, 128));
+
+    for (int i = 0; i < 10; ++i) {
+        ptr[i] = i;
+    }
+
+    ptr = alloc.reallocate(ptr, 10, 1000);
+    CHECK(is_aligned(ptr, 128));
+    CHECK(ptr[9] == 9);
+
+    alloc.deallocate(ptr, 1000);
+
+    cfds::malloc_allocator<block> blocks;
+    block* b = blocks.allocate(3);
+    CHECK(is_aligned(b, 64));
+    b = blocks.reallocate(b, 3, 30);
+    CHECK(is_aligned(b, 64));
+    blocks.deallocate(b, 30);
+}
@@ -0,0 +1,120 @@
+#include <cfds/arena.hpp>
+#include <cfds/small_vector.hpp>
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <numeric>
+#include <string>
+
+namespace {
+
+int sum(const cfds::arena_small_vector_header<int>& v) {
+    return std::accumulate(v.begin(), v.end(), 0);
+}
+
+} // namespace
+
+TEST_CASE("Bump allocate from an arena", "[arena]") {
+    cfds::arena a(256);
+
+    SECTION("Allocations are aligned and don't overlap") {
+        char* first = static_cast<char*>(a.allocate(3, 1));
+        char* second = static_cast<char*>(a.allocate(8, 8));
+        char* third = static_cast<char*>(a.allocate(64, 64));
+
+        CHECK(reinterpret_cast<std::uintptr_t>(second) % 8 == 0);
+        CHECK(reinterpret_cast<std::uintptr_t>(third) % 64 == 0);
+        CHECK(second >= first + 3);
+        CHECK(third >= second + 8);
+    }
+
+    SECTION("Allocations larger than a chunk get their own chunk") {
+        void* small = a.allocate(16);
+        void* large = a.allocate(4096);
+
+        CHECK(small != nullptr);
+        CHECK(large != nullptr);
+    }
+
+    SECTION("The last allocation can be resized in place") {
+        void* first = a.allocate(16);
+        void* second = a.allocate(16);
+
+        CHECK(!a.try_resize(first, 16, 32));
+        CHECK(a.try_resize(second, 16, 64));
+        CHECK(a.allocate(1, 1) == static_cast<char*>(second) + 64);
+    }
+
+    SECTION("reset reuses the most recent chunk when it is the largest") {
+        a.allocate(100);
+        a.allocate(1000);
+
+        // Doesn't fit in the chunk made for the previous allocation.
+        void* last = a.allocate(8);
+        a.allocate(8);
+
+        a.reset();
+
+        CHECK(a.allocate(8) == last);
+    }
+
+    SECTION("reset keeps the largest chunk") {
+        void* large = a.allocate(4096);
+
+        // Starts a smaller chunk after the one sized for the large request.
+        a.allocate(8);
+
+        a.reset();
+
+        CHECK(a.allocate(4096) == large);
+    }
+}
+
+TEST_CASE("small_vector spilling into an arena", "[arena, small_vector]") {
+    cfds::arena a;
+
+    SECTION("Spill and grow") {
+        cfds::arena_small_vector<int, 2> v(a);
+
+        for (int i = 0; i < 100; ++i) {
+            v.push_back(i);
+        }
+
+        CHECK(!v.is_small());
+        CHECK(v.get_allocator().resource() == &a);
+        CHECK(sum(v) == 4950);
+    }
+
+    SECTION("Vectors with different inline sizes share the header") {
+        cfds::arena_small_vector<int, 2> v1({1, 2, 3}, a);
+        cfds::arena_small_vector<int, 8> v2({4, 5}, a);
+
+        CHECK(sum(v1) == 6);
+        CHECK(sum(v2) == 9);
+
+        v1 = std::move(v2);
+
+        CHECK(sum(v1) == 9);
+    }
+
+    SECTION("Non trivially relocatable elements") {
+        cfds::arena_small_vector<std::string, 1> v(a);
+        v.push_back("a");
+        v.push_back("b");
+        v.insert(v.begin(), "c");
+
+        CHECK(v.size() == 3);
+        CHECK(v[0] == "c");
+        CHECK(v[2] == "b");
+    }
+
+    SECTION("Moving between arenas takes the allocator along") {
+        cfds::arena other;
+        cfds::arena_small_vector<int, 1> v1({1, 2, 3}, a);
+        cfds::arena_small_vector<int, 1> v2(other);
+
+        v2 = std::move(v1);
+
+        CHECK(v2.get_allocator().resource() == &a);
+        CHECK(sum(v2) == 6);
+    }
+}
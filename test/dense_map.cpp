@@ -0,0 +1,297 @@
+#include <cfds/small_dense_map.hpp>
+#include <cfds/small_dense_set.hpp>
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+template <typename Set>
+std::vector<typename Set::key_type> sorted_keys(const Set& set) {
+    std::vector<typename Set::key_type> keys(set.begin(), set.end());
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+// Sends every key to the same group to exercise probing and tombstones.
+struct collide_hash {
+    std::size_t operator()(int) const noexcept { return 0; }
+};
+
+// Places key in group key modulo the number of groups by undoing the mixing
+// of the hash done by the table.
+struct group_hash {
+    std::size_t operator()(int key) const noexcept {
+        std::uint64_t hash = static_cast<std::uint64_t>(key) << 7;
+        hash ^= hash >> 33;
+        hash *= 0x4f74430c22a54005ull;
+        hash ^= hash >> 33;
+        return static_cast<std::size_t>(hash);
+    }
+};
+
+} // namespace
+
+TEST_CASE("Insert into small_dense_map", "[dense_map]") {
+    using map = cfds::small_dense_map<int, std::string, 8>;
+
+    SECTION("Elements are kept inline while they fit") {
+        map m;
+
+        CHECK(m.insert({3, "c"}).second);
+        CHECK(m.emplace(1, "a").second);
+        CHECK_FALSE(m.insert({1, "x"}).second);
+
+        CHECK(m.is_small());
+        CHECK(m.size() == 2);
+        CHECK(m.at(1) == "a");
+        CHECK(m.at(3) == "c");
+
+        for (int i = 10; i < 20; ++i) {
+            m[i] = std::to_string(i);
+        }
+
+        CHECK(!m.is_small());
+        CHECK(m.size() == 12);
+        CHECK(m.at(1) == "a");
+        CHECK(m.at(19) == "19");
+    }
+
+    SECTION("operator[] and try_emplace only construct missing values") {
+        cfds::small_dense_map<std::string, std::unique_ptr<int>, 4> m;
+
+        m["b"] = std::unique_ptr<int>(new int(2));
+        CHECK(m.try_emplace("a", new int(1)).second);
+        CHECK_FALSE(m.try_emplace("a", nullptr).second);
+
+        CHECK(*m["a"] == 1);
+        CHECK(*m.at("b") == 2);
+        CHECK(m["c"] == nullptr);
+        CHECK(m.size() == 3);
+    }
+
+    SECTION("insert_or_assign overwrites existing values") {
+        map m{{1, "a"}};
+
+        CHECK_FALSE(m.insert_or_assign(1, "b").second);
+        CHECK(m.insert_or_assign(2, "c").second);
+        CHECK(m.at(1) == "b");
+        CHECK(m.at(2) == "c");
+    }
+
+    SECTION("at throws for missing keys") {
+        const map m{{1, "a"}};
+
+        CHECK_THROWS_AS(m.at(2), std::out_of_range);
+    }
+}
+
+TEST_CASE("Look up keys in small_dense_set", "[dense_set]") {
+    // Inline, a single heap group and several heap groups.
+    int count = GENERATE(10, 50, 1000);
+
+    cfds::small_dense_set<int> s;
+    for (int i = 0; i < count; ++i) {
+        CHECK(s.insert(2 * i).second);
+    }
+
+    CHECK(s.size() == static_cast<std::size_t>(count));
+    CHECK(s.size() <= s.capacity() - s.capacity() / 8);
+
+    for (int i = 0; i < count; ++i) {
+        REQUIRE(s.find(2 * i) != s.end());
+        CHECK(*s.find(2 * i) == 2 * i);
+        CHECK_FALSE(s.contains(2 * i + 1));
+        CHECK(s.count(2 * i) == 1);
+    }
+
+    CHECK(static_cast<int>(std::distance(s.begin(), s.end())) == count);
+}
+
+TEST_CASE("Erase from small_dense_set", "[dense_set]") {
+    SECTION("Erased slots are reused") {
+        cfds::small_dense_set<int, 16, collide_hash> s;
+
+        for (int round = 0; round < 100; ++round) {
+            for (int i = 0; i < 10; ++i) {
+                REQUIRE(s.insert(round * 10 + i).second);
+            }
+
+            for (int i = 0; i < 10; ++i) {
+                REQUIRE(s.erase(round * 10 + i) == 1);
+            }
+        }
+
+        CHECK(s.empty());
+        CHECK(s.is_small());
+    }
+
+    SECTION("Tombstones don't hide keys probed past them") {
+        cfds::small_dense_set<int, 16, collide_hash> s;
+
+        for (int i = 0; i < 100; ++i) {
+            s.insert(i);
+        }
+
+        for (int i = 0; i < 100; i += 2) {
+            CHECK(s.erase(i) == 1);
+        }
+
+        for (int i = 0; i < 100; ++i) {
+            CHECK(s.contains(i) == (i % 2 == 1));
+        }
+
+        for (int i = 100; i < 200; ++i) {
+            s.insert(i);
+        }
+
+        CHECK(s.size() == 150);
+        CHECK(s.contains(199));
+        CHECK_FALSE(s.contains(0));
+    }
+
+    SECTION("Erasing through iterators visits every element once") {
+        cfds::small_dense_set<int, 8> s{1, 2, 3, 4, 5, 6, 7};
+        std::vector<int> erased;
+
+        CHECK(sorted_keys(s) == (std::vector<int>{1, 2, 3, 4, 5, 6, 7}));
+
+        for (auto pos = s.begin(); pos != s.end();) {
+            erased.push_back(*pos);
+            pos = s.erase(pos);
+        }
+
+        std::sort(erased.begin(), erased.end());
+        CHECK(erased == (std::vector<int>{1, 2, 3, 4, 5, 6, 7}));
+        CHECK(s.empty());
+    }
+}
+
+TEST_CASE("Clear tombstones in place", "[dense_set]") {
+    SECTION("Erasing and reinserting keeps a table inline") {
+        cfds::small_dense_set<int, 8> s;
+
+        for (int i = 0; i < 1000; ++i) {
+            s.insert(i);
+            if (s.size() > 3) s.erase(i - 3);
+        }
+
+        CHECK(s.is_small());
+        CHECK(s.capacity() == 8);
+        CHECK(sorted_keys(s) == (std::vector<int>{997, 998, 999}));
+    }
+
+    SECTION("Elements are moved and swapped into their groups") {
+        cfds::small_dense_map<int, std::string, 32, group_hash> m;
+
+        // Group 1 fills up and the rest of the keys overflow into group 0.
+        for (int key = 1; key < 56; key += 2) {
+            m[key] = std::to_string(key);
+        }
+
+        // Tombstones are left behind in the full group 1, all but the first
+        // element of the group are erased.
+        for (int key = 3; key < 32; key += 2) {
+            REQUIRE(m.erase(key) == 1);
+        }
+
+        // Takes an empty slot of group 0 without any growth left.
+        m[0] = "0";
+
+        CHECK(m.is_small());
+        CHECK(m.capacity() == 32);
+        CHECK(m.size() == 14);
+        CHECK(m.at(0) == "0");
+        CHECK(m.at(1) == "1");
+
+        for (int key = 33; key < 56; key += 2) {
+            CHECK(m.at(key) == std::to_string(key));
+        }
+    }
+}
+
+TEST_CASE("Rehash small_dense_set of non trivial elements", "[dense_set]") {
+    cfds::small_dense_set<std::string, 4> s;
+    std::unordered_set<std::string> expected;
+
+    for (int i = 0; i < 200; ++i) {
+        std::string key(static_cast<std::size_t>(i % 40), 'x');
+        key += std::to_string(i);
+
+        s.insert(key);
+        expected.insert(key);
+    }
+
+    CHECK(s.size() == expected.size());
+
+    for (const std::string& key : expected) {
+        CHECK(s.contains(key));
+    }
+
+    s.clear();
+    CHECK(s.empty());
+    CHECK_FALSE(s.contains("x0"));
+}
+
+TEST_CASE("Copy, move and swap small_dense_map", "[dense_map]") {
+    using map = cfds::small_dense_map<int, std::string, 4>;
+
+    map small{{1, "a"}, {2, "b"}};
+    map large;
+    for (int i = 0; i < 20; ++i) {
+        large[i] = std::to_string(i);
+    }
+
+    REQUIRE(small.is_small());
+    REQUIRE(!large.is_small());
+
+    SECTION("Copies compare equal") {
+        map small_copy(small);
+        map large_copy;
+        large_copy = large;
+
+        CHECK(small_copy == small);
+        CHECK(large_copy == large);
+        CHECK(small_copy != large_copy);
+
+        small_copy[1] = "x";
+        CHECK(small_copy != small);
+    }
+
+    SECTION("Moving leaves the source empty") {
+        map small_moved(std::move(small));
+        map large_moved;
+        large_moved = std::move(large);
+
+        CHECK(small.empty());
+        CHECK(large.empty());
+        CHECK(small.is_small());
+        CHECK(large.is_small());
+        CHECK(small_moved.at(2) == "b");
+        CHECK(large_moved.at(19) == "19");
+    }
+
+    SECTION("Swapping inline and heap tables") {
+        swap(small, large);
+
+        CHECK(small.size() == 20);
+        CHECK(large.size() == 2);
+        CHECK(large.is_small());
+        CHECK(large.at(1) == "a");
+        CHECK(small.at(7) == "7");
+
+        map other{{3, "c"}};
+        swap(large, other);
+
+        CHECK(other.size() == 2);
+        CHECK(large.at(3) == "c");
+        CHECK(other.at(2) == "b");
+    }
+}
@@ -0,0 +1,103 @@
+#include <cfds/small_vector.hpp>
+#include <catch2/catch.hpp>
+#include <numeric>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+int sum(const cfds::external_small_vector_header<int>& v) {
+    return std::accumulate(v.begin(), v.end(), 0);
+}
+
+// Sizes the scratch vector of every call from its depth.
+int sum_of_ranges(int depth) {
+    if (depth == 0) return 0;
+
+    typename std::aligned_storage<sizeof(int), alignof(int)>::type storage[8];
+    cfds::external_small_vector<int> scratch(storage, depth < 8 ? depth : 8);
+
+    for (int i = 1; i <= depth; ++i) {
+        scratch.push_back(i);
+    }
+
+    return sum(scratch) + sum_of_ranges(depth - 1);
+}
+
+} // namespace
+
+TEST_CASE("small_vector with a caller provided buffer", "[external]") {
+    using storage_type = std::aligned_storage<sizeof(int), alignof(int)>::type;
+    storage_type storage[4];
+
+    SECTION("Elements are stored in the buffer until it's full") {
+        cfds::external_small_vector<int> v(storage, 4);
+
+        CHECK(v.capacity() == 4);
+        CHECK(v.is_small());
+
+        v.assign({1, 2, 3, 4});
+
+        CHECK(v.is_small());
+        CHECK(v.data() == reinterpret_cast<int*>(storage));
+
+        v.push_back(5);
+
+        CHECK(!v.is_small());
+        CHECK(sum(v) == 15);
+    }
+
+    SECTION("Moved from vectors return to their buffer") {
+        storage_type other_storage[2];
+        cfds::external_small_vector<int> v1(storage, 4);
+        cfds::external_small_vector<int> v2(other_storage, 2);
+
+        v1.assign({1, 2, 3, 4, 5});
+        v2 = std::move(v1);
+
+        CHECK(sum(v2) == 15);
+        CHECK(v1.empty());
+        CHECK(v1.is_small());
+        CHECK(v1.capacity() == 4);
+
+        v1.push_back(6);
+
+        CHECK(v1.data() == reinterpret_cast<int*>(storage));
+    }
+
+    SECTION("Swapping keeps each buffer with its vector") {
+        storage_type other_storage[2];
+        cfds::external_small_vector<int> v1(storage, 4);
+        cfds::external_small_vector<int> v2(other_storage, 2);
+
+        v1.assign({1, 2, 3, 4, 5});
+        v2.assign({6, 7, 8});
+        swap(v1, v2);
+
+        CHECK(sum(v1) == 21);
+        CHECK(sum(v2) == 15);
+
+        v1.clear();
+        v1.shrink_to_fit();
+
+        CHECK(v1.is_small());
+        CHECK(v1.capacity() == 4);
+    }
+
+    SECTION("Non trivial elements are destroyed") {
+        std::aligned_storage<sizeof(std::string),
+                             alignof(std::string)>::type strings[2];
+        cfds::external_small_vector<std::string> v(strings, 2);
+
+        v.push_back("a");
+        v.push_back(std::string(100, 'b'));
+        v.push_back("c");
+
+        CHECK(v.size() == 3);
+        CHECK(v[1].size() == 100);
+    }
+
+    SECTION("Runtime sized scratch vectors in recursive code") {
+        CHECK(sum_of_ranges(10) == 220);
+    }
+}
@@ -0,0 +1,251 @@
+#include <cfds/small_flat_map.hpp>
+#include <cfds/small_flat_set.hpp>
+#include <catch2/catch.hpp>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+template <typename Map>
+std::vector<typename Map::key_type> keys_of(const Map& map) {
+    std::vector<typename Map::key_type> keys;
+
+    for (const auto& value : map) {
+        keys.push_back(value.first);
+    }
+
+    return keys;
+}
+
+struct throw_on_copy {
+    int value;
+
+    explicit throw_on_copy(int v) : value(v) {}
+    throw_on_copy(throw_on_copy&&) = default;
+    throw_on_copy& operator=(throw_on_copy&&) = default;
+
+    throw_on_copy(const throw_on_copy& other) : value(other.value) {
+        if (value < 0) throw std::runtime_error("copy");
+    }
+
+    throw_on_copy& operator=(const throw_on_copy&) = default;
+};
+
+} // namespace
+
+TEST_CASE("Insert into small_flat_map", "[flat_map]") {
+    using map = cfds::small_flat_map<int, std::string, 4>;
+
+    SECTION("Elements are kept sorted and inline while they fit") {
+        map m;
+
+        CHECK(m.insert({3, "c"}).second);
+        CHECK(m.insert({1, "a"}).second);
+        CHECK(m.emplace(2, "b").second);
+        CHECK_FALSE(m.insert({1, "x"}).second);
+
+        CHECK(m.is_small());
+        CHECK(m.size() == 3);
+        CHECK(keys_of(m) == (std::vector<int>{1, 2, 3}));
+        CHECK(m.at(1) == "a");
+
+        m[5] = "e";
+        m[0] = "z";
+
+        CHECK(!m.is_small());
+        CHECK(keys_of(m) == (std::vector<int>{0, 1, 2, 3, 5}));
+    }
+
+    SECTION("operator[] and try_emplace only construct missing values") {
+        cfds::small_flat_map<std::string, std::unique_ptr<int>, 2> m;
+
+        m["b"] = std::unique_ptr<int>(new int(2));
+        CHECK(m.try_emplace("a", new int(1)).second);
+        CHECK_FALSE(m.try_emplace("a", nullptr).second);
+
+        CHECK(*m["a"] == 1);
+        CHECK(*m.at("b") == 2);
+        CHECK(m["c"] == nullptr);
+        CHECK(m.size() == 3);
+    }
+
+    SECTION("insert_or_assign overwrites existing values") {
+        map m{{1, "a"}};
+
+        CHECK_FALSE(m.insert_or_assign(1, "b").second);
+        CHECK(m.insert_or_assign(2, "c").second);
+        CHECK(m.at(1) == "b");
+        CHECK(m.at(2) == "c");
+    }
+
+    SECTION("Inserting with a hint") {
+        map m{{1, "a"}, {5, "e"}};
+
+        auto pos = m.insert(m.find(5), {3, "c"});
+        CHECK(pos->first == 3);
+
+        pos = m.insert(m.begin(), {7, "g"});
+        CHECK(pos->first == 7);
+
+        pos = m.insert(m.end(), {3, "x"});
+        CHECK(pos->second == "c");
+        CHECK(keys_of(m) == (std::vector<int>{1, 3, 5, 7}));
+    }
+
+    SECTION("at throws for missing keys") {
+        const map m{{1, "a"}};
+
+        CHECK_THROWS_AS(m.at(2), std::out_of_range);
+    }
+}
+
+TEST_CASE("Look up keys in small_flat_map", "[flat_map]") {
+    // Below and above the number of elements searched linearly.
+    int count = GENERATE(5, 100);
+
+    cfds::small_flat_map<int, int, 8> m;
+    for (int i = 0; i < count; ++i) {
+        m.emplace(2 * i, i);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        REQUIRE(m.find(2 * i) != m.end());
+        CHECK(m.find(2 * i)->second == i);
+        CHECK_FALSE(m.contains(2 * i + 1));
+        CHECK(m.lower_bound(2 * i + 1) == m.find(2 * i + 2));
+        CHECK(m.upper_bound(2 * i) == m.lower_bound(2 * i + 1));
+        CHECK(m.count(2 * i) == 1);
+    }
+
+    CHECK(m.find(-1) == m.end());
+    CHECK(m.find(2 * count) == m.end());
+    CHECK(m.lower_bound(2 * count) == m.end());
+
+    auto range = m.equal_range(4);
+    CHECK(std::distance(range.first, range.second) == 1);
+
+    range = m.equal_range(3);
+    CHECK(range.first == range.second);
+}
+
+TEST_CASE("Construct small_flat_map from unsorted ranges", "[flat_map]") {
+    // The first value of a key wins, like inserting one by one.
+    std::vector<std::pair<int, char>> values{
+        {4, 'a'}, {2, 'b'}, {4, 'c'}, {1, 'd'}, {2, 'e'}};
+
+    for (int i = 0; i < 10; ++i) {
+        values.emplace_back(100 - i, 'f');
+    }
+
+    cfds::small_flat_map<int, char, 4> m(values.begin(), values.end());
+    std::map<int, char> sorted(values.begin(), values.end());
+    std::vector<std::pair<int, char>> expected(sorted.begin(), sorted.end());
+
+    CHECK(std::vector<std::pair<int, char>>(m.begin(), m.end()) == expected);
+    CHECK(m.at(4) == 'a');
+    CHECK(m.at(2) == 'b');
+
+    std::istringstream stream("3 1 2 1");
+    cfds::small_flat_set<int, 4> s{std::istream_iterator<int>(stream),
+                                   std::istream_iterator<int>()};
+
+    CHECK(s == (cfds::small_flat_set<int, 4>{1, 2, 3}));
+}
+
+TEST_CASE("Bulk insert into small_flat_map", "[flat_map]") {
+    using map = cfds::small_flat_map<int, std::string, 4>;
+
+    SECTION("Sorted ranges are merged keeping existing values") {
+        map m{{2, "b"}, {4, "d"}, {6, "f"}};
+        std::vector<std::pair<int, std::string>> values{
+            {1, "a"}, {4, "x"}, {5, "e"}, {7, "g"}};
+
+        m.insert(cfds::sorted_unique, values.begin(), values.end());
+
+        CHECK(keys_of(m) == (std::vector<int>{1, 2, 4, 5, 6, 7}));
+        CHECK(m.at(4) == "d");
+        CHECK(values[0].second == "a");
+    }
+
+    SECTION("Sorted ranges after the last element are appended") {
+        map m{{1, "a"}};
+        m.insert(cfds::sorted_unique, {{2, "b"}, {3, "c"}});
+
+        CHECK(keys_of(m) == (std::vector<int>{1, 2, 3}));
+    }
+
+    SECTION("Unsorted ranges are sorted before merging") {
+        map m{{5, "e"}, {1, "a"}};
+        m.insert({{3, "c"}, {5, "x"}, {2, "b"}, {3, "y"}});
+
+        CHECK(keys_of(m) == (std::vector<int>{1, 2, 3, 5}));
+        CHECK(m.at(3) == "c");
+        CHECK(m.at(5) == "e");
+    }
+
+    SECTION("Merging keeps the elements if copying a value throws") {
+        cfds::small_flat_map<int, throw_on_copy, 2> m;
+        m.emplace(2, throw_on_copy(2));
+        m.emplace(4, throw_on_copy(4));
+
+        std::vector<std::pair<int, throw_on_copy>> values;
+        values.emplace_back(1, throw_on_copy(1));
+        values.emplace_back(3, throw_on_copy(-3));
+
+        CHECK_THROWS_AS(
+            m.insert(cfds::sorted_unique, values.begin(), values.end()),
+            std::runtime_error);
+
+        CHECK(keys_of(m) == (std::vector<int>{1, 2, 4}));
+        CHECK(m.at(4).value == 4);
+    }
+}
+
+TEST_CASE("Erase from small_flat_map", "[flat_map]") {
+    cfds::small_flat_map<int, int, 4> m{{1, 1}, {2, 2}, {3, 3}, {4, 4}};
+
+    CHECK(m.erase(2) == 1);
+    CHECK(m.erase(2) == 0);
+
+    auto pos = m.erase(m.begin());
+    CHECK(pos->first == 3);
+
+    m.erase(m.begin(), m.end());
+    CHECK(m.empty());
+}
+
+TEST_CASE("small_flat_set", "[flat_set]") {
+    using set = cfds::small_flat_set<std::string, 2, std::greater<std::string>>;
+
+    set s{"b", "a", "c", "a"};
+
+    CHECK(s.size() == 3);
+    CHECK(*s.begin() == "c");
+    CHECK(s.contains("a"));
+    CHECK_FALSE(s.insert("b").second);
+    CHECK(s.insert("d").first == s.begin());
+
+    set other(cfds::sorted_unique, {"z", "y"});
+    swap(s, other);
+
+    CHECK(s == (set{"y", "z"}));
+    CHECK(other.size() == 4);
+    CHECK(other < s);
+    CHECK(s > other);
+    CHECK(other <= s);
+    CHECK(s >= other);
+    CHECK(s <= s);
+    CHECK(s >= s);
+    CHECK(s != other);
+
+    static_assert(
+        std::is_same<set::iterator, set::const_iterator>::value,
+        "the keys of a small_flat_set can't be modified through iterators");
+}
@@ -0,0 +1,205 @@
+#include <cfds/small_ring.hpp>
+#include <cfds/small_vector.hpp>
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+template <typename Ring>
+std::vector<typename Ring::value_type> to_vector(const Ring& ring) {
+    return std::vector<typename Ring::value_type>(ring.begin(), ring.end());
+}
+
+// Concatenates the segments of ring, which has to give back the elements.
+template <typename Ring>
+std::vector<typename Ring::value_type> from_segments(const Ring& ring) {
+    auto parts = ring.segments();
+    std::vector<typename Ring::value_type> values(parts.first.begin(),
+                                                  parts.first.end());
+    values.insert(values.end(), parts.second.begin(), parts.second.end());
+    return values;
+}
+
+} // namespace
+
+TEST_CASE("Push and pop small_ring", "[ring]") {
+    cfds::small_ring<int, 4> ring;
+    CHECK(ring.empty());
+    CHECK(ring.capacity() == 4);
+
+    ring.push_back(2);
+    ring.push_back(3);
+    ring.push_front(1);
+    ring.emplace_front(0);
+    CHECK(ring.is_small());
+    CHECK(to_vector(ring) == (std::vector<int>{0, 1, 2, 3}));
+    CHECK(ring.front() == 0);
+    CHECK(ring.back() == 3);
+    CHECK(ring[2] == 2);
+    CHECK(ring.at(3) == 3);
+    CHECK_THROWS_AS(ring.at(4), std::out_of_range);
+
+    SECTION("Wrapping around the inline buffer") {
+        ring.pop_back();
+        ring.pop_back();
+        ring.push_back(4);
+        ring.push_back(5);
+
+        CHECK(ring.is_small());
+        CHECK(to_vector(ring) == (std::vector<int>{0, 1, 4, 5}));
+
+        auto parts = ring.segments();
+        CHECK(parts.first.size() == 2);
+        CHECK(parts.second.size() == 2);
+        CHECK(parts.second.data() == &ring[2]);
+        CHECK(from_segments(ring) == to_vector(ring));
+    }
+
+    SECTION("Spilling to the heap keeps the order") {
+        ring.pop_front();
+        ring.push_back(4);
+        ring.push_back(5);
+        ring.push_front(-1);
+
+        CHECK(!ring.is_small());
+        CHECK(ring.capacity() == 8);
+        CHECK(to_vector(ring) == (std::vector<int>{-1, 1, 2, 3, 4, 5}));
+        CHECK(from_segments(ring) == to_vector(ring));
+
+        for (int i = 6; i < 20; ++i) {
+            ring.push_back(i);
+            ring.pop_front();
+        }
+
+        CHECK(ring.size() == 6);
+        CHECK(ring.capacity() == 8);
+        CHECK(to_vector(ring) == (std::vector<int>{14, 15, 16, 17, 18, 19}));
+        CHECK(from_segments(ring) == to_vector(ring));
+    }
+
+    SECTION("Popping from the back") {
+        ring.pop_back();
+        ring.pop_back();
+        CHECK(to_vector(ring) == (std::vector<int>{0, 1}));
+
+        ring.clear();
+        CHECK(ring.empty());
+        CHECK(ring.segments().first.empty());
+    }
+
+    SECTION("Draining starts over at the front of the buffer") {
+        ring.pop_back();
+        ring.pop_front();
+        ring.pop_front();
+        ring.pop_front();
+        ring.push_back(7);
+
+        CHECK(&ring.front() == ring.segments().first.data());
+        CHECK(ring.segments().first.size() == 1);
+        CHECK(ring.segments().second.empty());
+    }
+}
+
+TEST_CASE("Iterate small_ring", "[ring]") {
+    cfds::small_ring<int, 4> ring{3, 4, 5};
+    ring.push_front(2);
+    ring.push_front(1);
+
+    CHECK(ring.end() - ring.begin() == 5);
+    CHECK(*(ring.begin() + 2) == 3);
+    CHECK(ring.begin()[4] == 5);
+    CHECK(std::vector<int>(ring.rbegin(), ring.rend()) ==
+          (std::vector<int>{5, 4, 3, 2, 1}));
+
+    cfds::small_ring<int, 4>::const_iterator iter = ring.begin();
+    CHECK(iter == ring.cbegin());
+    CHECK(iter < ring.cend());
+
+    std::reverse(ring.begin(), ring.end());
+    CHECK(to_vector(ring) == (std::vector<int>{5, 4, 3, 2, 1}));
+
+    std::sort(ring.begin(), ring.end());
+    CHECK(to_vector(ring) == (std::vector<int>{1, 2, 3, 4, 5}));
+    CHECK(std::lower_bound(ring.begin(), ring.end(), 4) - ring.begin() == 3);
+}
+
+TEST_CASE("small_ring of non trivial elements", "[ring]") {
+    cfds::small_ring<std::string, 2> strings;
+    strings.emplace_back("a string which is too long to be inline");
+    strings.emplace_front(3, 'b');
+    strings.push_back("c");
+
+    CHECK(!strings.is_small());
+    CHECK(to_vector(strings) ==
+          (std::vector<std::string>{
+              "bbb", "a string which is too long to be inline", "c"}));
+
+    cfds::small_ring<std::unique_ptr<int>, 2> pointers;
+    for (int i = 0; i < 5; ++i) {
+        pointers.emplace_back(new int(i));
+        pointers.emplace_front(new int(-i));
+    }
+
+    CHECK(pointers.size() == 10);
+    CHECK(*pointers.front() == -4);
+    CHECK(*pointers.back() == 4);
+
+    pointers.pop_front();
+    pointers.pop_back();
+    CHECK(*pointers.front() == -3);
+    CHECK(*pointers.back() == 3);
+}
+
+TEST_CASE("Copy, move and swap small_ring", "[ring]") {
+    using ring = cfds::small_ring<std::string, 2>;
+
+    ring small{"a"};
+    small.push_front("b");
+    ring large{"c", "d", "e"};
+
+    SECTION("Copies compare equal") {
+        ring small_copy(small);
+        ring large_copy(large);
+        CHECK(small_copy == small);
+        CHECK(large_copy == large);
+
+        small_copy = large;
+        CHECK(small_copy == large);
+        CHECK(small_copy != small);
+    }
+
+    SECTION("Moving steals the heap buffer") {
+        const std::string* first = &large.front();
+
+        ring moved(std::move(large));
+        CHECK(&moved.front() == first);
+        CHECK(large.empty());
+        CHECK(large.is_small());
+
+        moved = std::move(small);
+        CHECK(to_vector(moved) == (std::vector<std::string>{"b", "a"}));
+        CHECK(moved.is_small());
+        CHECK(small.empty());
+    }
+
+    SECTION("Swapping inline and heap rings") {
+        swap(small, large);
+        CHECK(to_vector(small) == (std::vector<std::string>{"c", "d", "e"}));
+        CHECK(to_vector(large) == (std::vector<std::string>{"b", "a"}));
+        CHECK(large.is_small());
+    }
+
+    SECTION("Relocated by small_vector") {
+        cfds::small_vector<ring, 1> rings;
+        rings.push_back(small);
+        rings.push_back(large);
+
+        CHECK(rings[0] == small);
+        CHECK(rings[1] == large);
+    }
+}
@@ -0,0 +1,150 @@
+#include <cfds/small_vector.hpp>
+#include <cfds/static_vector.hpp>
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> to_vector(
+    const cfds::static_vector<std::string, 4>& v) {
+    return std::vector<std::string>(v.begin(), v.end());
+}
+
+} // namespace
+
+TEST_CASE("Layout of static_vector", "[static_vector]") {
+    static_assert(sizeof(cfds::static_vector<char, 15>) == 16,
+                  "a single byte holds the size of small vectors");
+    static_assert(sizeof(cfds::static_vector<std::uint16_t, 300>) == 602,
+                  "two bytes hold sizes up to 65535");
+    static_assert(sizeof(cfds::static_vector<int, 0>) == sizeof(int),
+                  "an empty vector only holds its size");
+
+    static_assert(cfds::meta::is_trivially_relocatable<
+                      cfds::static_vector<std::unique_ptr<int>, 4>>::value,
+                  "static_vector relocates like its elements");
+
+    cfds::static_vector<int, 4> v{1, 2};
+    CHECK(static_cast<void*>(v.data()) == static_cast<void*>(&v));
+    CHECK(v.capacity() == 4);
+}
+
+TEST_CASE("Push into static_vector", "[static_vector]") {
+    cfds::static_vector<std::string, 4> v;
+
+    v.push_back("a");
+    v.emplace_back(2, 'b');
+    CHECK(*v.try_emplace_back("c") == "c");
+    CHECK(v.try_push_back("d") != nullptr);
+    CHECK(v.full());
+
+    SECTION("Overflowing throws and leaves the vector untouched") {
+        CHECK_THROWS_AS(v.push_back("e"), std::length_error);
+        CHECK_THROWS_AS(v.insert(v.begin(), "e"), std::length_error);
+        CHECK_THROWS_AS(v.resize(5), std::length_error);
+        CHECK(to_vector(v) == (std::vector<std::string>{"a", "bb", "c", "d"}));
+    }
+
+    SECTION("try_push_back reports overflow") {
+        std::string value("e");
+
+        CHECK(v.try_push_back(std::move(value)) == nullptr);
+        CHECK(value == "e");
+        CHECK(v.size() == 4);
+    }
+
+    SECTION("Popping makes room again") {
+        v.pop_back();
+        v.pop_back();
+        v.push_back("x");
+
+        CHECK(to_vector(v) == (std::vector<std::string>{"a", "bb", "x"}));
+    }
+}
+
+TEST_CASE("Insert into and erase from static_vector", "[static_vector]") {
+    cfds::static_vector<std::string, 4> v{"b", "d"};
+
+    v.insert(v.begin(), "a");
+    v.insert(v.begin() + 2, v[0]);
+    CHECK(to_vector(v) == (std::vector<std::string>{"a", "b", "a", "d"}));
+
+    v.erase(v.begin() + 1, v.begin() + 3);
+    CHECK(to_vector(v) == (std::vector<std::string>{"a", "d"}));
+
+    std::vector<std::string> values{"b", "c"};
+    auto pos = v.insert(v.begin() + 1, values.begin(), values.end());
+    CHECK(*pos == "b");
+    CHECK(to_vector(v) == (std::vector<std::string>{"a", "b", "c", "d"}));
+
+    v.erase(v.begin());
+    v.erase(v.end() - 1);
+    v.insert(v.end(), 2, "z");
+    CHECK(to_vector(v) == (std::vector<std::string>{"b", "c", "z", "z"}));
+
+    SECTION("Input iterators are rolled back when they don't fit") {
+        cfds::static_vector<int, 4> w{1, 2};
+        std::istringstream stream("3 4 5");
+
+        CHECK_THROWS_AS(w.insert(w.begin(), std::istream_iterator<int>(stream),
+                                 std::istream_iterator<int>()),
+                        std::length_error);
+        CHECK(w == (cfds::static_vector<int, 4>{1, 2}));
+    }
+}
+
+TEST_CASE("Copy, move and swap static_vector", "[static_vector]") {
+    cfds::static_vector<std::string, 4> x{"a", "b", "c"};
+    cfds::static_vector<std::string, 4> y{"d"};
+
+    SECTION("Copies compare equal") {
+        cfds::static_vector<std::string, 4> copy(x);
+        CHECK(copy == x);
+
+        copy = y;
+        CHECK(copy == y);
+        CHECK(copy != x);
+        CHECK(x < y);
+    }
+
+    SECTION("Moving") {
+        cfds::static_vector<std::string, 4> moved(std::move(x));
+        CHECK(to_vector(moved) == (std::vector<std::string>{"a", "b", "c"}));
+
+        moved = std::move(y);
+        CHECK(to_vector(moved) == (std::vector<std::string>{"d"}));
+    }
+
+    SECTION("Swapping vectors of different sizes") {
+        swap(x, y);
+        CHECK(to_vector(x) == (std::vector<std::string>{"d"}));
+        CHECK(to_vector(y) == (std::vector<std::string>{"a", "b", "c"}));
+
+        cfds::static_vector<std::unique_ptr<int>, 4> p;
+        cfds::static_vector<std::unique_ptr<int>, 4> q;
+        p.emplace_back(new int(1));
+        q.emplace_back(new int(2));
+        q.emplace_back(new int(3));
+
+        p.swap(q);
+        CHECK(p.size() == 2);
+        CHECK(*p[1] == 3);
+        CHECK(*q[0] == 1);
+    }
+
+    SECTION("Relocated by small_vector") {
+        cfds::small_vector<cfds::static_vector<std::string, 4>, 1> vectors;
+        vectors.push_back(x);
+        vectors.push_back(y);
+
+        CHECK(vectors[0] == x);
+        CHECK(vectors[1] == y);
+    }
+}
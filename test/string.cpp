@@ -0,0 +1,205 @@
+#include <cfds/small_string.hpp>
+#include <cfds/small_vector.hpp>
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <string>
+#include <utility>
+
+using string = cfds::small_string<8>;
+
+TEST_CASE("Construct small_string", "[string]") {
+    SECTION("Strings are null terminated inline and on the heap") {
+        string empty;
+        string small("small");
+        string large("longer than eight");
+
+        CHECK(empty.empty());
+        CHECK(std::strcmp(empty.c_str(), "") == 0);
+        CHECK(small.is_small());
+        CHECK(small.size() == 5);
+        CHECK(small.capacity() == 8);
+        CHECK(std::strcmp(small.c_str(), "small") == 0);
+        CHECK(!large.is_small());
+        CHECK(std::strcmp(large.c_str(), "longer than eight") == 0);
+    }
+
+    SECTION("From characters, counts and std::string") {
+        CHECK(string("abcdef", 3) == "abc");
+        CHECK(string(10, 'x') == "xxxxxxxxxx");
+        CHECK(string({'a', 'b'}) == "ab");
+        CHECK(string(std::string("from std")) == "from std");
+        CHECK(std::string(string("to std")) == "to std");
+    }
+
+    SECTION("Copying and moving") {
+        string small("small");
+        string large("longer than eight");
+
+        string small_copy(small);
+        string large_copy(large);
+        CHECK(small_copy == small);
+        CHECK(large_copy == large);
+
+        string small_moved(std::move(small));
+        string large_moved(std::move(large));
+        CHECK(small_moved == "small");
+        CHECK(large_moved == "longer than eight");
+        CHECK(small.empty());
+        CHECK(large.empty());
+        CHECK(*large.c_str() == '\0');
+
+        // The moved from string is back in its inline buffer.
+        CHECK(large.is_small());
+        CHECK(large.capacity() == 8);
+
+        cfds::small_string<32> other(large_moved);
+        CHECK(other.is_small());
+        CHECK(other == large_moved);
+    }
+
+    SECTION("Moving through small_string_header") {
+        cfds::small_string<32> large(40, 'x');
+        cfds::small_string_header& header = large;
+
+        string target("target");
+        cfds::small_string_header& target_header = target;
+        target_header = std::move(header);
+
+        CHECK(target == std::string(40, 'x'));
+        CHECK(large.empty());
+        CHECK(large.is_small());
+        CHECK(large.capacity() == 32);
+
+        large.append(32, 'y');
+        CHECK(large.is_small());
+    }
+}
+
+TEST_CASE("Append to small_string", "[string]") {
+    string s("ab");
+
+    s += 'c';
+    s += "def";
+    s.append(std::string("gh"));
+    CHECK(s == "abcdefgh");
+    CHECK(s.is_small());
+
+    s.push_back('i');
+    CHECK(s == "abcdefghi");
+    CHECK(!s.is_small());
+    CHECK(s.size() == 9);
+
+    s.append(3, '!');
+    CHECK(s == "abcdefghi!!!");
+
+    SECTION("Appending parts of itself while growing") {
+        string t("12345678");
+        t.append(t.data(), t.size());
+        t.append(t.c_str() + 4);
+
+        CHECK(t == "1234567812345678567812345678");
+        CHECK(t.size() == std::strlen(t.c_str()));
+    }
+
+    SECTION("Popping and resizing keep the terminator") {
+        s.pop_back();
+        CHECK(s == "abcdefghi!!");
+
+        s.resize(3);
+        CHECK(s == "abc");
+        CHECK(s.c_str()[3] == '\0');
+
+        s.resize(5, 'z');
+        CHECK(s == "abczz");
+    }
+}
+
+TEST_CASE("Assign and erase small_string", "[string]") {
+    string s("hello world");
+
+    s.assign(s.data() + 6, 5);
+    CHECK(s == "world");
+
+    s = "a much longer string than before";
+    CHECK(s.size() == 32);
+
+    s.erase(1, 5);
+    CHECK(s == "a longer string than before");
+
+    s.erase(s.begin());
+    CHECK(s == " longer string than before");
+
+    s.erase(8);
+    CHECK(s == " longer ");
+
+    s.clear();
+    CHECK(s.empty());
+    CHECK(*s.c_str() == '\0');
+
+    CHECK_THROWS_AS(s.erase(1), std::out_of_range);
+}
+
+TEST_CASE("Compare and search small_string", "[string]") {
+    string s("metric.name.total");
+
+    CHECK(s == std::string("metric.name.total"));
+    CHECK(s != "metric");
+    CHECK(string("abc") < string("abd"));
+    CHECK(string("ab") < string("abc"));
+    CHECK(string("b") > cfds::small_string<32>("abc"));
+    CHECK(s.compare("metric.name.total") == 0);
+    CHECK(s.compare("metric.z") < 0);
+
+    CHECK(s.find('.') == 6);
+    CHECK(s.find('.', 7) == 11);
+    CHECK(s.find('x') == string::npos);
+    CHECK(s.find("name") == 7);
+    CHECK(s.find("total", 12) == 12);
+    CHECK(s.find("totals") == string::npos);
+    CHECK(s.find("") == 0);
+    CHECK(s.rfind('.') == 11);
+    CHECK(s.rfind('.', 10) == 6);
+    CHECK(s.substr(7, 4) == "name");
+    CHECK(s.substr(12) == "total");
+
+#if CFDS_HAS_STRING_VIEW
+    std::string_view view = s;
+    CHECK(view == "metric.name.total");
+    CHECK(s == std::string_view("metric.name.total"));
+
+    string from_view(view.substr(0, 6));
+    CHECK(from_view == "metric");
+#endif
+}
+
+TEST_CASE("Swap and relocate small_string", "[string]") {
+    string small("small");
+    string large("longer than eight");
+
+    swap(small, large);
+    CHECK(small == "longer than eight");
+    CHECK(large == "small");
+    CHECK(large.is_small());
+
+    small.shrink_to_fit();
+    CHECK(!small.is_small());
+
+    small = "tiny";
+    small.shrink_to_fit();
+    CHECK(small.is_small());
+    CHECK(small == "tiny");
+
+    // Growing a vector of strings relocates the inline ones bytewise.
+    static_assert(cfds::meta::is_nothrow_relocatable<string>::value,
+                  "small_string can be relocated");
+
+    cfds::small_vector<string, 1> strings;
+    strings.emplace_back("first");
+    strings.emplace_back("a string on the heap");
+    strings.emplace_back("third");
+
+    CHECK(strings[0] == "first");
+    CHECK(strings[0].is_small());
+    CHECK(strings[1] == "a string on the heap");
+    CHECK(strings[2] == "third");
+}
@@ -1,10 +1,16 @@
 #include <algorithm>
 #include <catch2/catch.hpp>
 #include <cfds/small_vector.hpp>
+#include <cstdint>
 #include <iterator>
+#include <limits>
+#include <list>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 TEST_CASE("Construction of small_vector_header",
           "[small_vector_header, construction]") {
@@ -465,3 +471,1035 @@ TEST_CASE("Compare small_vector", "[small_vector, comparison]") {
     CHECK(v2 >= v2);
     CHECK(v2 <= v2);
 }
+
+TEST_CASE("Copy and move construct small_vector",
+          "[small_vector, constructor]") {
+    cfds::small_vector<std::string, 2> v{"aa", "bb"};
+
+    SECTION("Copy inline small_vector") {
+        cfds::small_vector<std::string, 2> copy(v);
+        v[0] = "cc";
+
+        CHECK(copy.is_small());
+        CHECK(copy.size() == 2);
+        CHECK(copy[0] == "aa");
+        CHECK(copy[1] == "bb");
+    }
+
+    SECTION("Move heap small_vector") {
+        v.push_back("cc");
+        const std::string* data = v.data();
+        cfds::small_vector<std::string, 2> moved(std::move(v));
+
+        CHECK(moved.data() == data);
+        CHECK(moved.size() == 3);
+        CHECK(moved[2] == "cc");
+    }
+
+    SECTION("Copy assign inline small_vector") {
+        cfds::small_vector<std::string, 2> copy{"dd"};
+        copy = v;
+        v.clear();
+
+        CHECK(copy.size() == 2);
+        CHECK(copy[0] == "aa");
+        CHECK(copy[1] == "bb");
+    }
+}
+
+namespace {
+
+struct counting_resource {
+    int allocations = 0;
+    int deallocations = 0;
+};
+
+template <typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    counting_resource* resource;
+
+    explicit counting_allocator(counting_resource* r) : resource(r) {}
+
+    template <typename U>
+    counting_allocator(const counting_allocator<U>& other)
+        : resource(other.resource) {}
+
+    T* allocate(std::size_t count) {
+        ++resource->allocations;
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* ptr, std::size_t count) {
+        ++resource->deallocations;
+        std::allocator<T>().deallocate(ptr, count);
+    }
+
+    friend bool operator==(const counting_allocator& x,
+                           const counting_allocator& y) {
+        return x.resource == y.resource;
+    }
+
+    friend bool operator!=(const counting_allocator& x,
+                           const counting_allocator& y) {
+        return !(x == y);
+    }
+};
+
+} // namespace
+
+TEST_CASE("small_vector with custom allocator", "[small_vector, allocator]") {
+    counting_resource resource;
+    counting_allocator<int> alloc(&resource);
+
+    SECTION("Spill, grow and shrink through the allocator") {
+        {
+            cfds::small_vector<int, 2, counting_allocator<int>> v(alloc);
+            v.push_back(1);
+            v.push_back(2);
+
+            CHECK(resource.allocations == 0);
+
+            v.push_back(3);
+            v.push_back(4);
+            v.push_back(5);
+
+            CHECK(v.get_allocator() == alloc);
+            CHECK(resource.allocations == 2);
+            CHECK(resource.deallocations == 1);
+
+            v.shrink_to_fit();
+
+            CHECK(resource.allocations == 3);
+            CHECK(resource.deallocations == 2);
+        }
+
+        CHECK(resource.deallocations == 3);
+    }
+
+    SECTION("Move steals the buffer when allocators are equal") {
+        cfds::small_vector<int, 1, counting_allocator<int>> v1({1, 2, 3},
+                                                               alloc);
+        cfds::small_vector<int, 1, counting_allocator<int>> v2(alloc);
+        v2 = std::move(v1);
+
+        CHECK(resource.allocations == 1);
+        CHECK(v1.empty());
+        CHECK(v2.size() == 3);
+    }
+
+    SECTION("Move copies elements when allocators differ") {
+        counting_resource other_resource;
+        counting_allocator<int> other_alloc(&other_resource);
+
+        cfds::small_vector<int, 1, counting_allocator<int>> v1({1, 2, 3},
+                                                               alloc);
+        cfds::small_vector<int, 1, counting_allocator<int>> v2(other_alloc);
+        v2 = std::move(v1);
+
+        CHECK(resource.allocations == 1);
+        CHECK(other_resource.allocations == 1);
+        CHECK(v2.get_allocator() == other_alloc);
+        CHECK(v2.size() == 3);
+        CHECK(v2[2] == 3);
+    }
+}
+
+#if CFDS_HAS_PMR
+TEST_CASE("pmr small_vector spills into memory_resource",
+          "[small_vector, allocator, pmr]") {
+    char buffer[256];
+    std::pmr::monotonic_buffer_resource resource(
+        buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+    cfds::pmr::small_vector<int, 2> v(&resource);
+    v.assign({1, 2, 3, 4});
+
+    CHECK_FALSE(v.is_small());
+    CHECK(reinterpret_cast<char*>(v.data()) >= buffer);
+    CHECK(reinterpret_cast<char*>(v.data()) < buffer + sizeof(buffer));
+
+    auto fn = [](cfds::pmr::small_vector_header<int>& ref) {
+        ref.push_back(5);
+    };
+
+    fn(v);
+
+    CHECK(v.size() == 5);
+    CHECK(v[4] == 5);
+}
+#endif
+
+TEST_CASE("Grow heap buffer with reallocate", "[small_vector, reallocate]") {
+    SECTION("Trivially copyable elements") {
+        cfds::small_vector<int, 2> v{0, 1};
+
+        for (int i = 2; i < 1000; ++i) {
+            v.push_back(i);
+        }
+
+        v.insert(v.begin() + 1, 3, -1);
+        v.shrink_to_fit();
+
+        CHECK(v.size() == 1003);
+        CHECK(v.capacity() == 1003);
+        CHECK(v[0] == 0);
+        CHECK(v[1] == -1);
+        CHECK(v[3] == -1);
+        CHECK(v[4] == 1);
+        CHECK(v[1002] == 999);
+    }
+
+    SECTION("Trivially relocatable elements") {
+        cfds::small_vector<std::unique_ptr<int>, 1> v;
+
+        for (int i = 0; i < 100; ++i) {
+            v.push_back(std::unique_ptr<int>(new int(i)));
+        }
+
+        v.shrink_to_fit();
+
+        CHECK(v.size() == 100);
+        CHECK(*v[0] == 0);
+        CHECK(*v[99] == 99);
+    }
+}
+
+TEST_CASE("Grow across mapped_allocator threshold",
+          "[small_vector, reallocate]") {
+    cfds::small_vector<int, 0, cfds::mapped_allocator<int, 4096>> v;
+
+    for (int i = 0; i < 10000; ++i) {
+        v.push_back(i);
+    }
+
+    CHECK(v.size() == 10000);
+    CHECK(v[0] == 0);
+    CHECK(v[5000] == 5000);
+    CHECK(v[9999] == 9999);
+
+    v.resize(10);
+    v.shrink_to_fit();
+
+    CHECK(v.capacity() == 10);
+    CHECK(v[9] == 9);
+}
+
+TEST_CASE("Grow small_vector with growth policies",
+          "[small_vector, growth_policy]") {
+    SECTION("power_of_two_growth") {
+        cfds::small_vector<int, 4> v{1, 2, 3, 4};
+        v.push_back(5);
+
+        CHECK(v.capacity() == 8);
+
+        v.insert(v.begin(), 4, 0);
+
+        CHECK(v.capacity() == 16);
+    }
+
+    SECTION("factor_growth") {
+        using policy = cfds::factor_growth<>;
+        cfds::small_vector<int, 4, cfds::malloc_allocator<int>, policy> v{
+            1, 2, 3, 4};
+        v.push_back(5);
+
+        CHECK(v.capacity() == 6);
+
+        v.insert(v.begin(), 2, 0);
+
+        CHECK(v.capacity() == 9);
+        CHECK(v.size() == 7);
+        CHECK(v[2] == 1);
+    }
+
+    SECTION("fixed_step_growth") {
+        using policy = cfds::fixed_step_growth<3>;
+        cfds::small_vector<int, 4, cfds::malloc_allocator<int>, policy> v{
+            1, 2, 3, 4};
+        v.insert(v.begin(), 0);
+
+        CHECK(v.capacity() == 7);
+
+        v.push_back(5);
+        v.push_back(6);
+        v.push_back(7);
+
+        CHECK(v.capacity() == 10);
+    }
+
+    SECTION("size_class_growth") {
+        using policy = cfds::size_class_growth<>;
+        cfds::small_vector<char, 1, cfds::malloc_allocator<char>, policy> v;
+
+        for (char c = 'a'; c <= 'z'; ++c) {
+            v.push_back(c);
+        }
+
+        CHECK(v.capacity() >= 26);
+        CHECK(v.size() == 26);
+        CHECK(v.back() == 'z');
+    }
+}
+
+TEST_CASE("small_vector with compact_layout", "[small_vector, layout]") {
+    using compact = cfds::compact_small_vector<std::uint32_t, 2>;
+
+    if (sizeof(void*) == 8) {
+        CHECK(sizeof(cfds::small_vector<std::uint32_t, 2>) == 32);
+        CHECK(sizeof(compact) == 24);
+    }
+
+    compact v{1, 2};
+
+    CHECK(v.is_small());
+    CHECK(v.capacity() == 2);
+
+    v.push_back(3);
+    v.insert(v.begin(), 0);
+
+    CHECK_FALSE(v.is_small());
+    CHECK(v.size() == 4);
+    CHECK(v.capacity() == 4);
+    CHECK(v[0] == 0);
+    CHECK(v[3] == 3);
+
+    v.erase(v.begin() + 1);
+
+    const compact& ref = v;
+
+    CHECK(*ref.rbegin() == 3);
+    CHECK(v.size() == 3);
+
+    compact other{7};
+    swap(v, other);
+
+    CHECK(other.size() == 3);
+    CHECK(v.size() == 1);
+    CHECK(v[0] == 7);
+
+    v = std::move(other);
+
+    CHECK(v.size() == 3);
+    CHECK(other.empty());
+    CHECK(other.is_small());
+}
+
+TEST_CASE("small_vector with configurable size_type",
+          "[small_vector, size_type]") {
+    SECTION("large_small_vector uses std::size_t") {
+        cfds::large_small_vector<int, 2> v{1, 2, 3};
+
+        CHECK(std::is_same<decltype(v)::size_type, std::size_t>::value);
+        CHECK(v.max_size() > static_cast<std::size_t>(
+                                 std::numeric_limits<int>::max()));
+
+        std::size_t index = 2;
+        v.insert(v.begin() + index, 4);
+
+        CHECK(v.size() == 4);
+        CHECK(v[index] == 4);
+        CHECK(v.at(3) == 3);
+    }
+
+    SECTION("Growth saturates at max_size") {
+        using layout = cfds::basic_pointer_layout<std::int8_t>;
+        cfds::small_vector<char, 1, cfds::malloc_allocator<char>,
+                           cfds::power_of_two_growth, layout>
+            v;
+
+        CHECK(v.max_size() == 127);
+
+        for (int i = 0; i < 127; ++i) {
+            v.push_back('a');
+        }
+
+        CHECK(v.size() == 127);
+        CHECK(v.capacity() == 127);
+        CHECK_THROWS_AS(v.push_back('b'), std::length_error);
+        CHECK_THROWS_AS(v.insert(v.begin(), 'b'), std::length_error);
+        CHECK(v.size() == 127);
+    }
+}
+
+TEST_CASE("Resize without value initialization",
+          "[small_vector, resize_for_overwrite]") {
+    SECTION("resize value initializes") {
+        cfds::small_vector<int, 2> v{1};
+        v.resize(5);
+
+        CHECK(v.size() == 5);
+        CHECK(v[0] == 1);
+        CHECK(v[4] == 0);
+
+        v.resize(2);
+
+        CHECK(v.size() == 2);
+        CHECK(v[1] == 0);
+    }
+
+    SECTION("resize_for_overwrite keeps existing elements") {
+        cfds::small_vector<int, 2> v{1, 2};
+        v.resize_for_overwrite(100);
+
+        CHECK(v.size() == 100);
+        CHECK(v[0] == 1);
+        CHECK(v[1] == 2);
+
+        for (int i = 0; i < 100; ++i) {
+            v[i] = i;
+        }
+
+        CHECK(v[99] == 99);
+
+        v.resize_for_overwrite(3);
+
+        CHECK(v.size() == 3);
+        CHECK(v[2] == 2);
+    }
+
+    SECTION("resize_for_overwrite default constructs class types") {
+        cfds::small_vector<std::string, 1> v;
+        v.resize_for_overwrite(3);
+
+        CHECK(v.size() == 3);
+        CHECK(v[2].empty());
+    }
+
+    SECTION("append_uninitialized returns the appended storage") {
+        cfds::small_vector<char, 4> v{'a'};
+        char* first = v.append_uninitialized(3);
+
+        CHECK(v.size() == 4);
+        CHECK(v.is_small());
+        CHECK(first == v.data() + 1);
+
+        first[0] = 'b';
+        first[1] = 'c';
+        first[2] = 'd';
+
+        first = v.append_uninitialized(10);
+
+        CHECK(v.size() == 14);
+        CHECK(!v.is_small());
+        CHECK(first == v.data() + 4);
+        CHECK(v[3] == 'd');
+    }
+}
+
+TEST_CASE("Range operations with trivially copyable types",
+          "[small_vector, bulk]") {
+    struct pair {
+        int first;
+        double second;
+    };
+
+    SECTION("assign and resize fill with the value") {
+        cfds::small_vector<pair, 2> v;
+        v.assign(37, pair{1, 2.0});
+
+        CHECK(v.size() == 37);
+        CHECK(std::all_of(v.begin(), v.end(), [](const pair& p) {
+            return p.first == 1 && p.second == 2.0;
+        }));
+
+        v.resize(100, pair{3, 4.0});
+
+        CHECK(v.size() == 100);
+        CHECK(v[36].first == 1);
+        CHECK(v[37].first == 3);
+        CHECK(v[99].second == 4.0);
+    }
+
+    SECTION("insert count copies of a byte") {
+        cfds::small_vector<char, 4> v{'a', 'b'};
+        v.insert(v.begin() + 1, 5, 'x');
+
+        CHECK(std::string(v.begin(), v.end()) == "axxxxxb");
+    }
+
+    SECTION("Copy from contiguous and non contiguous ranges") {
+        std::vector<int> source{1, 2, 3, 4, 5};
+        std::list<int> list(source.begin(), source.end());
+
+        cfds::small_vector<int, 2> from_vector(source.begin(), source.end());
+        cfds::small_vector<int, 2> from_list(list.begin(), list.end());
+
+        CHECK(std::equal(source.begin(), source.end(), from_vector.begin()));
+        CHECK(from_vector == from_list);
+
+        from_list.insert(from_list.begin() + 2, source.data(),
+                         source.data() + 2);
+
+        CHECK(from_list.size() == 7);
+        CHECK(from_list[2] == 1);
+        CHECK(from_list[3] == 2);
+        CHECK(from_list[4] == 3);
+
+        from_vector.assign(list.begin(), list.end());
+
+        CHECK(from_vector.size() == 5);
+        CHECK(from_vector.back() == 5);
+
+        from_vector = from_list;
+
+        CHECK(from_vector == from_list);
+    }
+
+    SECTION("Converting copies go element by element") {
+        std::vector<short> source{1, 2, 3};
+        cfds::small_vector<long, 1> v(source.begin(), source.end());
+
+        CHECK(v.size() == 3);
+        CHECK(v[2] == 3);
+    }
+}
+
+TEST_CASE("Range operations with class types", "[small_vector, bulk]") {
+    cfds::small_vector<std::string, 2> v;
+    v.assign(3, "abc");
+
+    CHECK(v.size() == 3);
+    CHECK(v[2] == "abc");
+
+    std::vector<std::string> source{"d", "e"};
+    v.insert(v.begin() + 1, source.begin(), source.end());
+
+    CHECK(v.size() == 5);
+    CHECK(v[1] == "d");
+    CHECK(v[2] == "e");
+    CHECK(v[3] == "abc");
+
+    v.resize(7, "f");
+
+    CHECK(v.back() == "f");
+
+    cfds::small_vector<std::string, 2> copy;
+    copy = v;
+
+    CHECK(copy == v);
+}
+
+TEST_CASE("Insert from input iterators without temporary buffers",
+          "[small_vector, insert]") {
+    counting_resource resource;
+    counting_allocator<int> alloc(&resource);
+
+    SECTION("Spare inline capacity is used") {
+        cfds::small_vector<int, 8, counting_allocator<int>> v({1, 5}, alloc);
+        std::istringstream from("2 3 4");
+
+        auto iter = v.insert(v.begin() + 1, std::istream_iterator<int>(from),
+                             std::istream_iterator<int>());
+
+        CHECK(resource.allocations == 0);
+        CHECK(iter == v.begin() + 1);
+        CHECK(v == (cfds::small_vector<int, 8, counting_allocator<int>>(
+                       {1, 2, 3, 4, 5}, alloc)));
+    }
+
+    SECTION("Growing while inserting") {
+        cfds::small_vector<std::string, 1> v{"a", "e"};
+        std::istringstream from("b c d");
+
+        v.insert(v.begin() + 1, std::istream_iterator<std::string>(from),
+                 std::istream_iterator<std::string>());
+
+        CHECK(v.size() == 5);
+        CHECK(v[1] == "b");
+        CHECK(v[3] == "d");
+        CHECK(v[4] == "e");
+    }
+
+    SECTION("Inserting an empty range") {
+        cfds::small_vector<int, 2> v{1, 2};
+        std::istringstream from("");
+
+        auto iter = v.insert(v.end(), std::istream_iterator<int>(from),
+                             std::istream_iterator<int>());
+
+        CHECK(iter == v.end());
+        CHECK(v.size() == 2);
+    }
+}
+
+TEST_CASE("Insert several elements into the middle",
+          "[small_vector, insert]") {
+    SECTION("Shift non trivially relocatable elements in place") {
+        cfds::small_vector<std::string, 8> v{"a", "b", "c", "d"};
+        v.insert(v.begin() + 1, 2, "x");
+
+        CHECK(v == (cfds::small_vector<std::string, 8>{"a", "x", "x", "b",
+                                                       "c", "d"}));
+
+        std::vector<std::string> source{"y", "z"};
+        v.insert(v.begin(), source.begin(), source.end());
+
+        CHECK(v == (cfds::small_vector<std::string, 8>{"y", "z", "a", "x",
+                                                       "x", "b", "c", "d"}));
+    }
+
+    SECTION("Shift past the old end") {
+        cfds::small_vector<std::string, 8> v{"a", "b"};
+        v.insert(v.begin() + 1, 5, "x");
+
+        CHECK(v.size() == 7);
+        CHECK(v[0] == "a");
+        CHECK(v[5] == "x");
+        CHECK(v[6] == "b");
+    }
+
+    SECTION("Relocate into a new buffer around the gap") {
+        cfds::small_vector<std::string, 2> v{"a", "b", "c"};
+        v.insert(v.begin() + 2, {"x", "y"});
+
+        CHECK(v == (cfds::small_vector<std::string, 2>{"a", "b", "x", "y",
+                                                       "c"}));
+    }
+
+    SECTION("Repeated inserts reallocate a logarithmic number of times") {
+        counting_resource resource;
+        counting_allocator<int> alloc(&resource);
+        cfds::small_vector<int, 4, counting_allocator<int>> v(alloc);
+
+        for (int i = 0; i < 1024; ++i) {
+            int values[] = {i, i};
+            v.insert(v.begin() + v.size() / 2, std::begin(values),
+                     std::end(values));
+        }
+
+        CHECK(v.size() == 2048);
+        CHECK(resource.allocations <= 12);
+    }
+}
+
+TEST_CASE("Shrink back into the inline buffer", "[small_vector, shrink]") {
+    SECTION("shrink_to_fit moves elements that fit into the inline buffer") {
+        cfds::small_vector<std::string, 4> v{"a", "b", "c", "d", "e"};
+        v.erase(v.begin() + 1, v.end() - 1);
+
+        CHECK(!v.is_small());
+
+        v.shrink_to_fit();
+
+        CHECK(v.is_small());
+        CHECK(v.capacity() == 4);
+        CHECK(v == (cfds::small_vector<std::string, 4>{"a", "e"}));
+
+        v.push_back("f");
+
+        CHECK(v.is_small());
+    }
+
+    SECTION("shrink_to_fit through the header keeps a heap buffer") {
+        cfds::small_vector<int, 4> v{1, 2, 3, 4, 5, 6};
+        v.erase(v.begin() + 2, v.end());
+
+        cfds::small_vector_header<int>& header = v;
+        header.shrink_to_fit();
+
+        CHECK(!v.is_small());
+        CHECK(v.capacity() == 2);
+    }
+
+    SECTION("Elements that don't fit stay on the heap") {
+        cfds::small_vector<int, 2> v{1, 2, 3, 4, 5};
+        v.pop_back();
+        v.shrink_to_fit();
+
+        CHECK(!v.is_small());
+        CHECK(v.capacity() == 4);
+    }
+}
+
+TEST_CASE("Shrink automatically with hysteresis_growth",
+          "[small_vector, shrink]") {
+    using shrinking_vector =
+        cfds::small_vector<int, 4, cfds::malloc_allocator<int>,
+                           cfds::hysteresis_growth<>>;
+
+    shrinking_vector v;
+    for (int i = 0; i < 64; ++i) {
+        v.push_back(i);
+    }
+
+    CHECK(v.capacity() == 64);
+
+    SECTION("erase releases memory below a quarter of the capacity") {
+        auto iter = v.erase(v.begin() + 16, v.end() - 1);
+
+        CHECK(v.capacity() == 64);
+
+        iter = v.erase(iter - 1);
+
+        CHECK(v.size() == 16);
+        CHECK(v.capacity() == 32);
+        CHECK(*iter == 63);
+        CHECK(v[14] == 14);
+    }
+
+    SECTION("pop_back returns to the inline buffer") {
+        while (v.size() > 2) {
+            v.pop_back();
+        }
+
+        CHECK(v.is_small());
+        CHECK(v.capacity() == 4);
+        CHECK(v[1] == 1);
+    }
+
+    SECTION("clear returns to the inline buffer") {
+        v.clear();
+
+        CHECK(v.is_small());
+        CHECK(v.capacity() == 4);
+    }
+
+    SECTION("Moved from vectors keep their inline capacity") {
+        shrinking_vector other = std::move(v);
+
+        CHECK(other.size() == 64);
+        CHECK(v.is_small());
+        CHECK(v.capacity() == 4);
+    }
+
+    SECTION("assign doesn't release the buffer it's about to fill") {
+        int* data = v.data();
+        v.assign(40, 1);
+
+        CHECK(v.data() == data);
+    }
+}
+
+namespace {
+
+// Counts its relocations and checks that it's never moved afterwards.
+struct tracked {
+    static int relocations;
+    static int moves;
+
+    int value;
+
+    explicit tracked(int v) : value(v) {}
+    tracked(const tracked& other) : value(other.value) {}
+    tracked(tracked&& other) noexcept : value(other.value) { ++moves; }
+};
+
+int tracked::relocations = 0;
+int tracked::moves = 0;
+
+} // namespace
+
+namespace cfds {
+namespace meta {
+
+template <>
+struct relocate_traits<tracked> : std::true_type {
+    static void relocate(tracked* src, tracked* dest) noexcept {
+        ::new (static_cast<void*>(dest)) tracked(src->value);
+        ++tracked::relocations;
+    }
+};
+
+} // namespace meta
+} // namespace cfds
+
+TEST_CASE("Relocate elements through relocate_traits",
+          "[small_vector, relocate]") {
+    SECTION("Customized relocation replaces move and destroy") {
+        tracked::relocations = 0;
+        tracked::moves = 0;
+
+        cfds::small_vector<tracked, 2> v;
+        for (int i = 0; i < 9; ++i) {
+            v.emplace_back(i);
+        }
+
+        v.emplace(v.begin() + 1, 42);
+        v.erase(v.begin() + 3);
+
+        CHECK(tracked::moves == 0);
+        CHECK(tracked::relocations > 0);
+        CHECK(v.size() == 9);
+        CHECK(v[1].value == 42);
+        CHECK(v[3].value == 3);
+        CHECK(v[8].value == 8);
+    }
+
+    SECTION("Nested small_vectors keep their inline and heap elements") {
+        using inner_type = cfds::small_vector<std::string, 2>;
+
+        static_assert(cfds::meta::relocate_traits<inner_type>::value, "");
+        static_assert(std::is_nothrow_move_constructible<inner_type>::value,
+                      "");
+
+        cfds::small_vector<inner_type, 2> v;
+        for (int i = 0; i < 20; ++i) {
+            inner_type inner;
+            for (int j = 0; j < i % 5; ++j) {
+                inner.push_back(std::to_string(i * 10 + j));
+            }
+
+            v.push_back(std::move(inner));
+        }
+
+        v.erase(v.begin() + 2);
+        v.insert(v.begin() + 1, inner_type{"x", "y", "z"});
+
+        REQUIRE(v.size() == 20);
+        CHECK(v[1] == (inner_type{"x", "y", "z"}));
+        CHECK(v[2] == (inner_type{"10"}));
+        CHECK(v[3] == (inner_type{"30", "31", "32"}));
+
+        for (auto& inner : v) {
+            CHECK(inner.is_small() == (inner.size() <= 2));
+        }
+
+        v[3].push_back("33");
+        CHECK(v[3].back() == "33");
+    }
+}
+
+namespace {
+
+// Trivially relocatable through its nested trait while counting the moves
+// and swaps that would otherwise be needed.
+struct swappable_handle {
+    using is_trivially_relocatable = std::true_type;
+
+    static int moves;
+
+    int value;
+
+    explicit swappable_handle(int v) : value(v) {}
+    swappable_handle(const swappable_handle& other) : value(other.value) {}
+    swappable_handle(swappable_handle&& other) noexcept : value(other.value) {
+        ++moves;
+    }
+
+    swappable_handle& operator=(swappable_handle&& other) noexcept {
+        value = other.value;
+        ++moves;
+        return *this;
+    }
+
+    ~swappable_handle() {}
+};
+
+int swappable_handle::moves = 0;
+
+template <typename Vector>
+std::vector<int> values_of(const Vector& v) {
+    std::vector<int> values;
+    for (const auto& handle : v) {
+        values.push_back(handle.value);
+    }
+    return values;
+}
+
+} // namespace
+
+TEST_CASE("Swap without moving the elements", "[small_vector, swap]") {
+    using handle_allocator = counting_allocator<swappable_handle>;
+    using vector = cfds::small_vector<swappable_handle, 4, handle_allocator>;
+
+    counting_resource resource;
+    handle_allocator alloc(&resource);
+
+    vector heap(alloc);
+    vector inline_vector(alloc);
+
+    for (int i = 0; i < 10; ++i) {
+        heap.emplace_back(i);
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        inline_vector.emplace_back(100 + i);
+    }
+
+    swappable_handle::moves = 0;
+    int allocations = resource.allocations;
+
+    SECTION("Heap buffer is handed over to the inline vector") {
+        swap(heap, inline_vector);
+
+        CHECK(heap.is_small());
+        CHECK(!inline_vector.is_small());
+        CHECK(values_of(heap) == (std::vector<int>{100, 101, 102}));
+        CHECK(inline_vector.size() == 10);
+        CHECK(inline_vector[9].value == 9);
+
+        inline_vector.swap(heap);
+
+        CHECK(!heap.is_small());
+        CHECK(inline_vector.is_small());
+        CHECK(heap[9].value == 9);
+        CHECK(values_of(inline_vector) == (std::vector<int>{100, 101, 102}));
+    }
+
+    SECTION("Inline vectors exchange their bytes") {
+        vector other(alloc);
+        other.emplace_back(7);
+
+        inline_vector.swap(other);
+
+        CHECK(values_of(inline_vector) == (std::vector<int>{7}));
+        CHECK(values_of(other) == (std::vector<int>{100, 101, 102}));
+    }
+
+    SECTION("Through the header the inline capacity is unknown") {
+        cfds::small_vector_header<swappable_handle, handle_allocator>& header =
+            inline_vector;
+        header.swap(heap);
+
+        CHECK(values_of(heap) == (std::vector<int>{100, 101, 102}));
+        CHECK(inline_vector.size() == 10);
+        allocations += 1;
+    }
+
+    CHECK(swappable_handle::moves == 0);
+    CHECK(resource.allocations == allocations);
+}
+
+TEST_CASE("Swap inline and heap vectors of strings", "[small_vector, swap]") {
+    cfds::small_vector<std::string, 2> heap{"a", "b", "c"};
+    cfds::small_vector<std::string, 2> small{"x"};
+
+    swap(heap, small);
+
+    CHECK(heap.is_small());
+    CHECK(heap == (cfds::small_vector<std::string, 2>{"x"}));
+    CHECK(small == (cfds::small_vector<std::string, 2>{"a", "b", "c"}));
+}
+
+TEST_CASE("Swap with an empty vector through the header",
+          "[small_vector, swap]") {
+    cfds::small_vector<int, 4> heap{1, 2, 3, 4, 5};
+    cfds::small_vector<int, 4> empty;
+
+    cfds::small_vector_header<int>& header = heap;
+    header.swap(empty);
+
+    CHECK(heap.empty());
+    CHECK(empty == (cfds::small_vector<int, 4>{1, 2, 3, 4, 5}));
+
+    // The inline buffer of heap is still usable.
+    CHECK(heap.capacity() >= 4);
+    heap.push_back(1);
+    heap.shrink_to_fit();
+    CHECK(heap.is_small());
+    CHECK(heap.capacity() == 4);
+}
+
+TEST_CASE("Append without capacity checks", "[small_vector, append]") {
+    SECTION("back_inserter_unchecked commits the size when destroyed") {
+        cfds::small_vector<int, 4> v{1, 2};
+        {
+            auto out = v.back_inserter_unchecked(10);
+
+            CHECK(v.capacity() >= 12);
+
+            for (int i = 3; i <= 12; ++i) {
+                out.push_back(i);
+            }
+
+            CHECK(v.size() == 2);
+        }
+
+        REQUIRE(v.size() == 12);
+        CHECK(v.back() == 12);
+        CHECK(v[2] == 3);
+    }
+
+    SECTION("Fewer elements than reserved can be appended") {
+        cfds::small_vector<std::string, 2> v;
+        {
+            auto out = v.back_inserter_unchecked(8);
+            out.emplace_back(3, 'a');
+            out.push_back("b");
+        }
+
+        CHECK(v == (cfds::small_vector<std::string, 2>{"aaa", "b"}));
+    }
+
+    SECTION("emplace_back_n appends the generated values") {
+        cfds::small_vector<int, 4> v{0};
+        int next = 1;
+        v.emplace_back_n(5, [&next] { return next++; });
+
+        CHECK(v == (cfds::small_vector<int, 4>{0, 1, 2, 3, 4, 5}));
+
+        v.emplace_back_n(0, [] { return -1; });
+
+        CHECK(v.size() == 6);
+    }
+
+    SECTION("emplace_back_n keeps the elements generated before a throw") {
+        cfds::small_vector<std::string, 2> v;
+        int calls = 0;
+
+        auto generator = [&calls] {
+            if (++calls == 4) throw std::runtime_error("generator");
+            return std::string(20, 'x');
+        };
+
+        CHECK_THROWS_AS(v.emplace_back_n(6, generator), std::runtime_error);
+        CHECK(v.size() == 3);
+        CHECK(v[2] == std::string(20, 'x'));
+    }
+}
+
+TEST_CASE("Manage buffers through small_vector_base", "[small_vector, base]") {
+    using vector = cfds::small_vector<std::uint16_t, 3>;
+
+    SECTION("Insert into the middle while spilling and on the heap") {
+        vector v{1, 2, 3};
+        v.insert(v.begin() + 1, {7, 8});
+
+        CHECK(!v.is_small());
+        CHECK(v == (vector{1, 7, 8, 2, 3}));
+
+        v.insert(v.begin(), 5, 9);
+
+        CHECK(v == (vector{9, 9, 9, 9, 9, 1, 7, 8, 2, 3}));
+
+        v.insert(v.end(), 20, 4);
+
+        CHECK(v.size() == 30);
+        CHECK(v[9] == 3);
+        CHECK(v[29] == 4);
+    }
+
+    SECTION("Shrink into a smaller heap buffer and into the inline buffer") {
+        vector v{1, 2, 3, 4, 5, 6, 7, 8, 9};
+        v.erase(v.begin() + 1, v.begin() + 5);
+        v.shrink_to_fit();
+
+        CHECK(!v.is_small());
+        CHECK(v.capacity() == 5);
+        CHECK(v == (vector{1, 6, 7, 8, 9}));
+
+        v.erase(v.begin(), v.begin() + 3);
+        v.shrink_to_fit();
+
+        CHECK(v.is_small());
+        CHECK(v == (vector{8, 9}));
+    }
+
+    SECTION("Over-aligned heap buffers") {
+        cfds::aligned_small_vector<char, 8> v{'a', 'a', 'a'};
+        v.insert(v.begin() + 1, 40, 'b');
+
+        CHECK(reinterpret_cast<std::uintptr_t>(v.data()) % 64 == 0);
+        CHECK(v.front() == 'a');
+        CHECK(v[40] == 'b');
+        CHECK(v.back() == 'a');
+
+        v.resize(2);
+        v.shrink_to_fit();
+
+        CHECK(v.is_small());
+        CHECK(v[1] == 'b');
+    }
+}
@@ -0,0 +1,102 @@
+#include <cfds/small_vector.hpp>
+#include <cfds/thread_cache.hpp>
+#include <catch2/catch.hpp>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Reuse blocks through the thread cache", "[thread_cache]") {
+    cfds::flush_thread_cache();
+    cfds::cached_allocator<int> alloc;
+
+    SECTION("Blocks of the same size class are reused") {
+        int* first = alloc.allocate(10);
+        alloc.deallocate(first, 10);
+
+        CHECK(cfds::thread_cache_bytes() == 64);
+
+        int* second = alloc.allocate(12);
+
+        CHECK(second == first);
+        CHECK(cfds::thread_cache_bytes() == 0);
+
+        alloc.deallocate(second, 12);
+    }
+
+    SECTION("Large blocks bypass the cache") {
+        std::size_t count = (std::size_t(1) << 16) / sizeof(int) + 1;
+        int* block = alloc.allocate(count);
+        alloc.deallocate(block, count);
+
+        CHECK(cfds::thread_cache_bytes() == 0);
+    }
+
+    SECTION("The cache is bounded per size class") {
+        std::vector<int*> blocks;
+
+        for (int i = 0; i < 10000; ++i) {
+            blocks.push_back(alloc.allocate(4));
+        }
+
+        for (int* block : blocks) {
+            alloc.deallocate(block, 4);
+        }
+
+        CHECK(cfds::thread_cache_bytes() == (std::size_t(1) << 17));
+    }
+
+    SECTION("Usable size covers the size class") {
+        int* block = alloc.allocate(9);
+
+        CHECK(alloc.usable_size(block, 9) == 16);
+
+        alloc.deallocate(block, 16);
+    }
+
+    cfds::flush_thread_cache();
+
+    CHECK(cfds::thread_cache_bytes() == 0);
+}
+
+TEST_CASE("small_vector spilling through the thread cache",
+          "[thread_cache, small_vector]") {
+    cfds::flush_thread_cache();
+
+    SECTION("Spilled buffers are recycled") {
+        int* data = nullptr;
+
+        {
+            cfds::cached_small_vector<int, 2> v{1, 2, 3};
+            data = v.data();
+
+            CHECK(v.capacity() == 4);
+        }
+
+        cfds::cached_small_vector<int, 2> v{4, 5, 6};
+
+        CHECK(v.data() == data);
+    }
+
+    SECTION("Vectors freed by other threads") {
+        std::vector<cfds::cached_small_vector<int, 1>> vectors(4);
+
+        std::vector<std::thread> threads;
+        for (auto& v : vectors) {
+            threads.emplace_back([&v] {
+                for (int i = 0; i < 1000; ++i) {
+                    v.push_back(i);
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        for (const auto& v : vectors) {
+            CHECK(std::accumulate(v.begin(), v.end(), 0) == 499500);
+        }
+    }
+
+    cfds::flush_thread_cache();
+}
@@ -1,5 +1,11 @@
 #include <cfds/small_vector.hpp>
 #include <catch2/catch.hpp>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
 
 TEST_CASE("get_buffer_address return correct address", "[utility, address]") {
     SECTION("get_buffer_address with small_vector") {
@@ -12,3 +18,96 @@ TEST_CASE("get_buffer_address return correct address", "[utility, address]") {
         CHECK(*(addr + 1) == 2);
     }
 }
+
+TEST_CASE("next_power_of_two saturates", "[utility, next_power_of_two]") {
+    CHECK(cfds::detail::next_power_of_two(0) == 1);
+    CHECK(cfds::detail::next_power_of_two(4) == 8);
+    CHECK(cfds::detail::next_power_of_two(5) == 8);
+    CHECK(cfds::detail::next_power_of_two(std::uint64_t(1) << 63) ==
+          std::numeric_limits<std::uint64_t>::max());
+}
+
+TEST_CASE("saturate_cast clamps to the target type",
+          "[utility, saturate_cast]") {
+    CHECK(cfds::detail::saturate_cast<int>(5) == 5);
+    CHECK(cfds::detail::saturate_cast<int>(std::uint64_t(1) << 40) ==
+          std::numeric_limits<int>::max());
+    CHECK(cfds::detail::saturate_cast<std::uint8_t>(300) == 255);
+}
+
+namespace {
+
+// Moving is observable but the handle never points into itself.
+struct handle {
+    static int moves;
+
+    int* resource;
+
+    explicit handle(int* r) : resource(r) {}
+    handle(handle&& other) noexcept : resource(other.resource) {
+        other.resource = nullptr;
+        ++moves;
+    }
+    ~handle() {}
+};
+
+int handle::moves = 0;
+
+struct nested_opt_in {
+    using is_trivially_relocatable = std::true_type;
+
+    nested_opt_in(nested_opt_in&&) noexcept {}
+};
+
+struct self_referencing {
+    self_referencing* self = this;
+
+    self_referencing() = default;
+    self_referencing(self_referencing&&) noexcept {}
+};
+
+} // namespace
+
+CFDS_TRIVIALLY_RELOCATABLE(handle)
+
+TEST_CASE("Detect trivially relocatable types", "[meta, relocate]") {
+    using cfds::meta::is_trivially_relocatable;
+
+    static_assert(is_trivially_relocatable<int>::value, "");
+    static_assert(is_trivially_relocatable<handle>::value, "");
+    static_assert(is_trivially_relocatable<nested_opt_in>::value, "");
+    static_assert(!is_trivially_relocatable<self_referencing>::value, "");
+    static_assert(is_trivially_relocatable<std::unique_ptr<int>>::value, "");
+    static_assert(is_trivially_relocatable<
+                      std::pair<int, std::unique_ptr<int>>>::value,
+                  "");
+    static_assert(!is_trivially_relocatable<
+                      std::pair<int, self_referencing>>::value,
+                  "");
+    static_assert(is_trivially_relocatable<std::allocator<int>>::value, "");
+
+#if defined(__GLIBCXX__) && !defined(_GLIBCXX_DEBUG)
+    static_assert(is_trivially_relocatable<std::vector<std::string>>::value,
+                  "");
+    static_assert(is_trivially_relocatable<std::function<int()>>::value, "");
+    static_assert(!is_trivially_relocatable<std::string>::value, "");
+#endif
+
+    SECTION("Declared types are relocated without moving them") {
+        int resources[8] = {};
+        cfds::small_vector<handle, 2> v;
+
+        for (int i = 0; i < 8; ++i) {
+            v.emplace_back(&resources[i]);
+        }
+
+        handle::moves = 0;
+        v.erase(v.begin());
+        v.reserve(64);
+
+        CHECK(handle::moves == 0);
+        CHECK(v.size() == 7);
+        CHECK(v[0].resource == &resources[1]);
+        CHECK(v[6].resource == &resources[7]);
+    }
+}